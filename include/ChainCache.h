@@ -0,0 +1,56 @@
+#ifndef CHAINCACHE_H
+#define CHAINCACHE_H
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include "CompleteID.h"
+
+#define chainCacheShardsNum 16
+#define chainCacheEntryOverhead 200 // approximate memory per entry in bytes (without the chain itself)
+
+using namespace std;
+
+// sharded LRU cache of first id -> serialized chain of supporting entries, can be used by several threads
+// each chain is stored with a stamp (e.g. its latest id) and only returned if the stamp still matches
+class ChainCache
+{
+public:
+    ChainCache(size_t maxSizeInBytes);
+    ~ChainCache();
+    bool get(CompleteID &id, const string &stamp, string &target);
+    void put(CompleteID &id, const string &stamp, const string &chainStr);
+    void erase(CompleteID &id);
+    void clear();
+    void setMaxSize(size_t maxSizeInBytes);
+    void report(string &msg);
+protected:
+private:
+    struct CachedChain
+    {
+        string key;
+        string stamp;
+        string chainStr;
+    };
+
+    struct Shard
+    {
+        mutex shard_mutex;
+        list<CachedChain> entries; // most recently used first
+        unordered_map<string, list<CachedChain>::iterator> entryByKey;
+        size_t sizeInBytes;
+        unsigned long long hits;
+        unsigned long long misses;
+        unsigned long long staleHits;
+    };
+
+    Shard shards[chainCacheShardsNum];
+    volatile size_t maxBytesPerShard;
+
+    Shard* getShard(const string &key);
+    static size_t entrySize(const CachedChain &entry);
+    void removeEntry(Shard* shard, list<CachedChain>::iterator it);
+};
+
+#endif // CHAINCACHE_H
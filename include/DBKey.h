@@ -0,0 +1,46 @@
+#ifndef DBKEY_H
+#define DBKEY_H
+
+#include <string>
+#include <cstring>
+#include "rocksdb/slice.h"
+#include "CompleteID.h"
+
+#define dbKeyMaxLength 128
+#define dbKeyIdLength 20 // length of CompleteID::to20Char()
+
+using namespace std;
+
+// key of a list with limited length, built on the stack and passed to rocksdb as slice
+class DBKey
+{
+public:
+    DBKey();
+    DBKey(char prefix);
+    DBKey(char prefix, CompleteID &id);
+    DBKey(char prefix, CompleteID &id, const char* suffix);
+    DBKey& add(char c);
+    DBKey& add(const char* str);
+    DBKey& add(const string &str);
+    DBKey& add(CompleteID &id);
+    void truncate(size_t length); // to reuse a common prefix
+    rocksdb::Slice slice() const;
+    size_t length() const;
+    bool isGood() const;
+    // access to keys from iterators without copying them
+    static bool startsWith(const rocksdb::Slice &key, const DBKey &prefix);
+    static CompleteID idAt(const rocksdb::Slice &key, size_t pos);
+    // layout of CompleteID::to20Char() without allocation, only used after checkIdLayout() confirmed it
+    static void writeId(CompleteID &id, char* out);
+    static CompleteID readId(const char* in);
+    static bool checkIdLayout();
+protected:
+private:
+    static bool ownIdLayout; // false: CompleteID::to20Char() and CompleteID(string) are used
+    char data[dbKeyMaxLength];
+    size_t len;
+    bool good; // false if dbKeyMaxLength was exceeded
+    void add(const char* str, size_t length);
+};
+
+#endif // DBKEY_H
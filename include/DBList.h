@@ -0,0 +1,66 @@
+#ifndef DBLIST_H
+#define DBLIST_H
+
+#include <string>
+#include <vector>
+#include "rocksdb/db.h"
+#include "rocksdb/options.h"
+#include "rocksdb/utilities/write_batch_with_index.h"
+#include "KeyFilter.h"
+
+using namespace std;
+
+// iterator which owns the upper bound used in its read options
+class BoundedIterator : public rocksdb::Iterator
+{
+public:
+    BoundedIterator(const string &bound);
+    ~BoundedIterator();
+    void setIterator(rocksdb::Iterator* i);
+    const rocksdb::Slice* getBound();
+    bool Valid() const override;
+    void SeekToFirst() override;
+    void SeekToLast() override;
+    void Seek(const rocksdb::Slice& target) override;
+    void SeekForPrev(const rocksdb::Slice& target) override;
+    void Next() override;
+    void Prev() override;
+    rocksdb::Slice key() const override;
+    rocksdb::Slice value() const override;
+    rocksdb::Status status() const override;
+protected:
+private:
+    const string upperBound;
+    const rocksdb::Slice upperBoundSlice;
+    rocksdb::Iterator* it;
+};
+
+// one of the lists of the database, stored as a column family of a shared rocksdb instance
+// while a write batch is active (*b != nullptr), writes are collected in it and reads see them
+class DBList
+{
+public:
+    DBList(rocksdb::DB* d, rocksdb::ColumnFamilyHandle* h, rocksdb::WriteBatchWithIndex** b);
+    ~DBList();
+    rocksdb::Status Put(const rocksdb::WriteOptions& options, const rocksdb::Slice& key, const rocksdb::Slice& value);
+    rocksdb::Status Get(const rocksdb::ReadOptions& options, const rocksdb::Slice& key, string* value);
+    rocksdb::Status Get(const rocksdb::ReadOptions& options, const rocksdb::Slice& key, rocksdb::PinnableSlice* value);
+    vector<rocksdb::Status> MultiGet(const rocksdb::ReadOptions& options, const vector<rocksdb::Slice>& keys, vector<string>* values);
+    rocksdb::Status Delete(const rocksdb::WriteOptions& options, const rocksdb::Slice& key);
+    rocksdb::Iterator* NewIterator(const rocksdb::ReadOptions& options);
+    rocksdb::Iterator* NewPrefixIterator(const rocksdb::Slice& prefix);
+    bool GetProperty(const rocksdb::Slice& property, string* value);
+    rocksdb::ColumnFamilyHandle* getHandle();
+    void setFilter(KeyFilter* f);
+    KeyFilter* getFilter();
+    void setPrefixLength(size_t length);
+protected:
+private:
+    rocksdb::DB* db;
+    rocksdb::ColumnFamilyHandle* handle;
+    rocksdb::WriteBatchWithIndex** batch;
+    KeyFilter* filter; // optional, keys covered by it are added on Put
+    size_t prefixLength; // length of the fixed prefix extractor (0 if none)
+};
+
+#endif // DBLIST_H
@@ -3,12 +3,31 @@
 
 #include <iostream>
 #include <cstdio>
+#include <cstdlib>
 #include <string>
 #include <map>
 #include <set>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <pthread.h>
 #include "rocksdb/db.h"
 #include "rocksdb/options.h"
 #include "rocksdb/table.h"
+#include "rocksdb/filter_policy.h"
+#include "rocksdb/slice_transform.h"
+#include "rocksdb/write_batch.h"
+#include "rocksdb/write_buffer_manager.h"
+#include "DBList.h"
+#include "DBKey.h"
+#include "IDCache.h"
+#include "ChainCache.h"
+#include "OrderBook.h"
+#include "NotaryTimeline.h"
+#include "NodeStatus.h"
+#include "DownloadScheduler.h"
+#include "DeadlineIndex.h"
+#include "Scheduler.h"
 #include "Entry.h"
 #include "Type1Entry.h"
 #include "Type2Entry.h"
@@ -47,33 +66,62 @@ using namespace std;
 class Database
 {
 public:
+    struct RenotarizationJob // entry to renotarize with the data needed for signing it
+    {
+        CompleteID entryId;
+        string t13eStr;
+        Type12Entry* t12e; // to be deleted by the caller
+    };
+
     Database(const string& dbDir);
     bool init(unsigned long ownNr, TNtrNr corrNotary, CryptoPP::RSA::PublicKey* corrNotaryPublicKey);
     ~Database();
     void rocksdbReport();
     void upToDateReport();
+    void commitReport();
+    void cachesReport();
+    void setIdCacheSize(size_t sizeInMb);
+    void setChainCacheSize(size_t sizeInMb);
+    void setCommitMode(unsigned char mode, unsigned long long maxDelayInMs);
+    void setSignaturePacking(bool on);
+    unsigned long long getNextWalSyncTime();
+    void syncWAL();
+    void setScheduler(Scheduler* s);
     bool loadNewerEntriesIds(unsigned char listType, CompleteID &benchmarkId, CIDsSet &newerIDs);
     CompleteID getUpToDateID(unsigned char listType);
     size_t getEntriesInDownload();
     CompleteID getNextEntryToDownload();
     CompleteID getOldestEntryToDownload();
+    unsigned long long getNextDownloadRetryTime();
     bool loadNextEntryToSign(string &type13entryStr, string &type12entryStr);
+    unsigned long long getNextSigningTime();
     bool isLastInBlock(CompleteID &signatureID);
     void updateRenotarizationAttempts();
     int loadNextEntryToRenotarize(CompleteID &entryId);
+    size_t loadNextEntriesToRenotarize(size_t maxEntries, list<RenotarizationJob> &jobs);
     void checkThreadTerminations();
+    unsigned long long getNextTerminationTime();
     bool loadNextTerminatingThread(CompleteID &lastEntryId);
+    size_t loadNextTerminatingThreads(size_t maxThreads, list<CompleteID> &lastEntryIds);
     bool addType13Entry(Type13Entry* entry, bool integrateIfPossible);
+    void addType13Entries(list<Type13Entry*> &entries);
+    CompleteID getIndividualUpToDateID(unsigned char listType, unsigned long notary);
     CompleteID newEntriesIdsReport(unsigned char listType, unsigned long notary, CompleteID id1, CompleteID id2);
     void addContactsToServers(OtherServersHandler *servers, unsigned long ownNr);
     void lock();
     void unlock();
+    void lockShared();
+    void unlockShared();
     set<unsigned long>* getActingNotaries(unsigned long long currentTime);
     CompleteID getLatestNotaryId(TNtrNr &totalNotaryNr);
     bool loadNotaryPubKey(TNtrNr &totalNotaryNr, string &str);
     bool isFreshNow(CompleteID &id);
     static unsigned long long systemTimeInMs();
     bool loadType13Entries(CompleteID &notEntryId, list<Type13Entry*> &targetList);
+    bool loadType13Entries(vector<CompleteID> &notEntryIds, vector<list<Type13Entry*>> &targetLists);
+    bool packNextSignatureLists();
+    bool loadCachedChain(CompleteID &firstId, string &stamp, string &chainStr);
+    void cacheChain(CompleteID &firstId, string &stamp, string &chainStr);
     CompleteID getFirstID(string* pubKey);
     CompleteID getCurrencyOrOblId(Type5Or15Entry* entry);
     size_t getRelatedEntries(CompleteID &id, list<CompleteID> &idsList);
@@ -82,7 +130,11 @@ public:
     Type14Entry* buildNextClaim(CompleteID &pubKeyID, CompleteID &currencyId);
     size_t getExchangeOffers(CompleteID &pubKeyID, CompleteID &currencyOId, CompleteID &currencyRId, unsigned short &rangeNum, unsigned short &maxNum, list<CompleteID> &idsList);
     void updateExchangeOfferRatio(CompleteID &offerId, Type12Entry* offerEntry);
+    void persistExchangeOfferRatios();
+    void saveCheckpoint();
+    void growKeyFilters();
     static Type12Entry* createT12FromT13Str(string &str);
+    static bool isInitialT13Str(const rocksdb::Slice &str);
     size_t getTransferRequests(CompleteID &pubKeyID, CompleteID &currencyId, CompleteID &maxId, unsigned short &maxNum, list<CompleteID> &idsList);
     size_t getApplications(string type, CompleteID &pubKeyID, bool isApplicant, CompleteID &currencyId, unsigned char status, CompleteID &minApplId,
                            unsigned short maxNum, list<CompleteID> &idsList);
@@ -97,6 +149,7 @@ public:
     bool amModerator(CompleteID &firstID);
     Type12Entry* buildUnderlyingEntry(CompleteID &firstId, unsigned char l);
     bool loadType13EntryStr(CompleteID &entryId, unsigned char l, string &str);
+    bool loadType13EntryPinned(CompleteID &entryId, unsigned char l, rocksdb::PinnableSlice &value);
     bool addToEntriesToSign(CompleteID &signatureId, unsigned short participationRank);
     bool amCurrentlyActingWithBuffer();
     bool amCurrentlyActing();
@@ -105,6 +158,8 @@ public:
     bool isActingNotary(TNtrNr tNtrNr, unsigned long long currentTime);
     bool isActingNotaryWithBuffer(TNtrNr tNtrNr, unsigned long long currentTime);
     bool dbUpToDate(unsigned long long wellConnectedSince);
+    void publishNodeStatus(unsigned long long wellConnectedSince);
+    bool amActingAndUpToDate();
     CompleteID getFirstID(CompleteID &id);
     CompleteID getLatestID(CompleteID &firstID);
     bool loadContactsList(set<unsigned long>* notaries, list<string> &contacts);
@@ -119,26 +174,80 @@ public:
     CompleteID getConnectedTransfer(CompleteID &transferId, CompleteID &currentRefId);
 protected:
 private:
-    mutex db_mutex;
+    pthread_rwlock_t db_rwlock; // exclusive for changes, shared for read-only queries
     Type1Entry* type1entry;
     rocksdb::BlockBasedTableOptions table_options;
-    rocksdb::DB* notaries;
-    rocksdb::DB* entriesInNotarization;
-    rocksdb::DB* notarizationEntries;
-    rocksdb::DB* publicKeys;
-    rocksdb::DB* subjectToRenotarization;
-    rocksdb::DB* notaryApplications;
-    rocksdb::DB* currenciesAndObligations;
-    rocksdb::DB* scheduledActions;
-    rocksdb::DB* essentialEntries;
-    rocksdb::DB* conflicts;
-    rocksdb::DB* perpetualEntries; // currencies, obligations and public keys
-    rocksdb::DB* transfersWithFees; // type 10 entries which are subject to notarization fees
+    rocksdb::DB* listsDB; // holds all of the following lists as column families
+    rocksdb::WriteBatchWithIndex* writeBatch; // active write batch (or nullptr)
+    unsigned int writeBatchDepth;
+    IDCache firstIdCache; // entry id -> id of first notarization entry (FN)
+    IDCache latestIdCache; // id of first notarization entry -> id of latest notarization entry (LN)
+    ChainCache chainCache; // id of first notarization entry -> serialized supporting entries (as sent to clients)
+    OrderBook orderBook; // exchange offers as stored in publicKeys and currenciesAndObligations (EO)
+    NotaryTimeline notaryTimeline; // tenure starts as stored in notaries (H, T2E), updated when notaries are added
+    NodeStatus nodeStatus; // acting and up-to-date status for request paths, published by the internal thread
+    mutex ratioUpdates_mutex;
+    set<CompleteID, CompleteID::CompareIDs> ratioUpdates; // ids of offers whose ratio in orderBook is not yet stored
+    map<CompleteID, OrderBook::Offer, CompleteID::CompareIDs> exchangeOffersInBatch; // reloaded if the batch fails
+
+    // group commit: 0 - no sync, 1 - one WAL sync for all batches within maxCommitDelayInMs, 2 - sync every batch
+    atomic<unsigned char> commitMode;
+    atomic<unsigned long long> maxCommitDelayInMs;
+    atomic<unsigned long long> nextWalSyncTime; // ULLONG_MAX if nothing to sync
+    mutex commitStats_mutex;
+    unsigned long long firstUnsyncedTime;
+    unsigned long long unsyncedBatches;
+    unsigned long long committedBatches;
+    unsigned long long committedKeys;
+    unsigned long long commitTimeTotalInMcrS;
+    unsigned long long commitTimeMaxInMcrS;
+    unsigned long long walSyncs;
+    unsigned long long syncedBatches;
+    unsigned long long syncTimeTotalInMcrS;
+    unsigned long long syncTimeMaxInMcrS;
+    unsigned long long syncDelayTotalInMs;
+    DBList* notaries;
+    DBList* entriesInNotarization;
+    DBList* notarizationEntries;
+    DBList* publicKeys;
+    DBList* subjectToRenotarization;
+    DBList* notaryApplications;
+    DBList* currenciesAndObligations;
+    DBList* scheduledActions;
+    DBList* essentialEntries;
+    DBList* conflicts;
+    DBList* perpetualEntries; // currencies, obligations and public keys
+    DBList* transfersWithFees; // type 10 entries which are subject to notarization fees
     Util util;
     unsigned long ownNumber;
     TNtrNr correspondingNotary;
     CryptoPP::RSA::PublicKey* correspondingNotaryPublicKey;
 
+    // collects all writes of one logical operation and writes them atomically
+    void beginWriteBatch();
+    bool commitWriteBatch();
+    class WriteBatchScope
+    {
+    public:
+        WriteBatchScope(Database* d) : database(d) { database->beginWriteBatch(); }
+        ~WriteBatchScope() { database->commitWriteBatch(); }
+    private:
+        Database* database;
+    };
+
+    void initKeyFilter(DBList* dbList, const string &prefix, const string &suffix);
+    void buildClaimsIndex();
+
+    bool packSignatureLists; // store new signature lists as one value (SP) instead of SLH + SLB<i>
+    string packingCursor; // next key to check for signature lists to pack (empty if done), stored in scheduledActions
+    unsigned long long packedListsCount;
+    string packSignatures(list<string> &entries);
+    bool unpackSignatures(const rocksdb::Slice &packed, vector<rocksdb::Slice> &entries);
+    bool loadPackedSignatures(CompleteID &notEntryId, string &packed);
+    rocksdb::ColumnFamilyOptions getListOptions(const string &listName);
+    size_t getListPrefixLength(const string &listName);
+    bool migrateOldList(const string& oldDir, DBList* target, rocksdb::ColumnFamilyOptions &cfOptions);
+
     struct UpToDateCondition
     {
         const CompleteID upToDateIDConditional;
@@ -160,23 +269,19 @@ private:
         CompleteID* getUpToDateIDOverall();
     };
 
-    struct DownloadStatus
-    {
-        set<pair<unsigned char,unsigned long>> neededFor; // pair(listType, notary)
-        volatile unsigned char attempts;
-    };
+    DownloadScheduler downloads; // entries to download with missing predecessors and notaries
 
-    volatile map<CompleteID, DownloadStatus*, CompleteID::CompareIDs> *entriesToDownload;
-    volatile map<CompleteID, DownloadStatus*, CompleteID::CompareIDs> *entriesInDownload;
-    map<CompleteID, CIDsSet*, CompleteID::CompareIDs> missingPredecessors;
-    map<CompleteID, set<unsigned long>*, CompleteID::CompareIDs> missingNotaries;
-    map<CompleteID, unsigned long long, CompleteID::CompareIDs> lastDownloadAttempt;
+    DeadlineIndex expectedTerminations; // as stored in scheduledActions (E), by termination time
+    DeadlineIndex renotarizationSubjects; // entries with parameters in subjectToRenotarization (P) but no own attempt, by next review
+    DeadlineIndex renotarizationAttempts; // own attempts as stored in subjectToRenotarization (A), by attempt time
 
     map<unsigned long, CompleteID> lastReportedIndividualUpToDate;
 
     CIDsSet conflictingEntries;
 
     set<pair<unsigned long long,CompleteID>, CompleteID::LLComparePairs> entriesToSign;
+    atomic<unsigned long long> nextSigningTime; // earliest time in entriesToSign, read without locking
+    Scheduler* scheduler; // of the internal thread, notified of new work (or nullptr)
 
     UpToDateTimeInfo* listEssentials;
     UpToDateTimeInfo* listGeneral;
@@ -261,10 +366,12 @@ private:
     bool addNextSignature(Type13Entry* entry, bool renot);
     bool storeRenotarizationParameters(CompleteID &entryId);
     void deleteRenotarizationParameters(CompleteID &entryId);
+    unsigned long long getNextRenotarizationReview(CompleteID &entryId, unsigned long listLength);
     bool loadUnderlyingType12EntryStr(CompleteID &entryId, unsigned char l, string &str);
     CompleteID getEntryInRenotarization(CompleteID &firstNotSignId);
     bool checkForConsistency(Type12Entry* entry, CompleteID &currentRefId);
     double addToTTLiquidityNotClaimedYet(CompleteID &keyID, CompleteID &entryID, unsigned char scenario, bool totalLiqui, double amount);
+    void storeExpectedTermination(CompleteID &threadId, unsigned long long terminationTime);
     bool storeT9eCreationParameters(CompleteID &threadId, unsigned long long &terminationTime);
     void deleteT9eCreationParameters(CompleteID &threadId);
     bool loadSigningNotaries(CompleteID &notEntryId, list<unsigned long> &notariesList);
@@ -273,6 +380,15 @@ private:
     unsigned long getNotaryInSchedule(CompleteID &entryId, unsigned long c, bool renot);
     bool removeFromExchangeOffersList(CompleteID &offerId, CompleteID &ownerId, CompleteID &currencyOId, CompleteID &currencyRId);
     void addToExchangeOffersList(CompleteID &offerId, CompleteID &ownerId, CompleteID &currencyOId, CompleteID &currencyRId, double amountR);
+    void noteExchangeOfferInBatch(CompleteID &offerId, CompleteID &ownerId, CompleteID &currencyOId, CompleteID &currencyRId);
+    bool deleteExchangeOfferKeys(CompleteID &offerId, CompleteID &ownerId, CompleteID &currencyOId, CompleteID &currencyRId);
+    void storeExchangeOfferKeys(CompleteID &offerId, CompleteID &ownerId, CompleteID &currencyOId, CompleteID &currencyRId,
+                                unsigned short range, double amountR, double exchangeRatio);
+    double getExchangeOfferRatio(CompleteID &offerId, CompleteID &ownerId, CompleteID &currencyOId, double amountR);
+    unsigned short getExchangeOfferRange(CompleteID &currencyRId, double amountR);
+    void initOrderBook();
+    bool loadExchangeOffer(const rocksdb::Slice &keySlice);
+    void reloadExchangeOffers();
     size_t loadOutgoingShares(TNtrNr &totalNotaryNr, map<unsigned long, double> &sharesMap);
     size_t loadIncomingShares(TNtrNr &totalNotaryNr, map<unsigned long, double> &sharesMap);
     double getShareToKeep(TNtrNr &totalNotaryNr);
@@ -280,6 +396,10 @@ private:
     double getCollectedFees(TNtrNr &totalNotaryNr, CompleteID &currencyID);
     void addToCollectedFees(TNtrNr &totalNotaryNr, CompleteID &currencyID, double amount);
     unsigned long long getNotaryTenureStart(TNtrNr tNtrNr);
+    unsigned long long loadNotaryTenureStart(TNtrNr tNtrNr);
+    void rebuildNotaryTimeline();
+    void loadDeadlineIndexes();
+    void loadCheckpoint();
     double getRedistributionMultiplier(TNtrNr &from, TNtrNr &to);
     void addToRedistributionMultiplier(TNtrNr &from, TNtrNr &to, double penaltyFactor);
     double getMultipliersSum(TNtrNr &from);
@@ -0,0 +1,33 @@
+#ifndef DEADLINEINDEX_H
+#define DEADLINEINDEX_H
+
+#include <string>
+#include <list>
+#include <map>
+#include <climits>
+#include "CompleteID.h"
+
+using namespace std;
+
+// in-memory index of scheduled ids by deadline (one deadline per id), the earliest first
+// not thread-safe (used with the db locked)
+class DeadlineIndex
+{
+public:
+    DeadlineIndex();
+    ~DeadlineIndex();
+    void clear();
+    void schedule(CompleteID &id, unsigned long long deadline); // replaces an earlier deadline of the id
+    void remove(CompleteID &id);
+    bool getDeadline(CompleteID &id, unsigned long long &deadline); // false if not scheduled
+    bool takeDue(unsigned long long time, CompleteID &id, unsigned long long &deadline); // removes the id
+    size_t size();
+    unsigned long long getEarliest(); // ULLONG_MAX if empty
+    void report(string &msg);
+protected:
+private:
+    multimap<unsigned long long, CompleteID> deadlines; // deadline -> id
+    map<CompleteID, multimap<unsigned long long, CompleteID>::iterator, CompleteID::CompareIDs> byId;
+};
+
+#endif // DEADLINEINDEX_H
@@ -0,0 +1,69 @@
+#ifndef DOWNLOADSCHEDULER_H
+#define DOWNLOADSCHEDULER_H
+
+#include <string>
+#include <list>
+#include <map>
+#include <set>
+#include <climits>
+#include "CompleteID.h"
+
+using namespace std;
+
+// entries to download as a dependency graph: entries wait for scheduled predecessors,
+// ready entries are taken from a queue and attempted entries are retried by a timer queue
+// not thread-safe (used with the db locked)
+class DownloadScheduler
+{
+public:
+    DownloadScheduler(size_t maxEntries, unsigned long long retryDelayInMs);
+    ~DownloadScheduler();
+    bool add(CompleteID &id, unsigned char listType, unsigned long notary); // true if newly scheduled
+    void addMissingPredecessor(CompleteID &id, CompleteID &predecessor);
+    void addMissingNotary(CompleteID &id, unsigned long notaryNr);
+    bool takeNextReady(unsigned long long currentTime, CompleteID &id);
+    unsigned char getAttempts(CompleteID &id);
+    set<unsigned long>* getMissingNotaries(CompleteID &id);
+    void attempted(CompleteID &id, unsigned long long currentTime);
+    bool remove(CompleteID &id, set<pair<unsigned char,unsigned long>> *neededFor);
+    size_t size();
+    CompleteID getOldest();
+    unsigned long long getNextRetryTime();
+    void loadEntries(map<CompleteID, set<pair<unsigned char,unsigned long>>, CompleteID::CompareIDs> &entries);
+    void report(string &msg);
+protected:
+private:
+    enum NodeState
+    {
+        stateReady, // in readyQueue
+        stateWaiting, // in retries
+        stateBlocked, // waiting for predecessors
+        stateTaken // returned by takeNextReady, until attempted or removed
+    };
+
+    struct Node
+    {
+        set<pair<unsigned char,unsigned long>> neededFor; // pair(listType, notary)
+        unsigned char attempts;
+        unsigned long long lastAttempt; // 0 if not yet attempted
+        NodeState state;
+        list<CompleteID>::iterator readyIt;
+        multimap<unsigned long long, CompleteID>::iterator retryIt;
+        set<CompleteID, CompleteID::CompareIDs> predecessors; // scheduled entries this one waits for
+        set<CompleteID, CompleteID::CompareIDs> dependents; // scheduled entries waiting for this one
+        set<unsigned long> missingNotaries;
+    };
+
+    const size_t maxNodes;
+    const unsigned long long retryDelay;
+    map<CompleteID, Node*, CompleteID::CompareIDs> nodes;
+    list<CompleteID> readyQueue;
+    multimap<unsigned long long, CompleteID> retries; // time -> id
+
+    Node* getNode(CompleteID &id);
+    void unqueue(Node* node);
+    void makeReady(CompleteID &id, Node* node);
+    void scheduleRetry(CompleteID &id, Node* node);
+};
+
+#endif // DOWNLOADSCHEDULER_H
@@ -0,0 +1,44 @@
+#ifndef IDCACHE_H
+#define IDCACHE_H
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include "CompleteID.h"
+
+#define idCacheShardsNum 16
+#define idCacheEntrySize 200 // approximate memory per entry in bytes
+
+using namespace std;
+
+// sharded LRU cache of id -> id mappings, can be used by several threads
+class IDCache
+{
+public:
+    IDCache(size_t maxSizeInBytes);
+    ~IDCache();
+    bool get(CompleteID &id, CompleteID &target);
+    void put(CompleteID &id, CompleteID &value);
+    void erase(CompleteID &id);
+    void clear();
+    void setMaxSize(size_t maxSizeInBytes);
+    void report(string &msg);
+protected:
+private:
+    struct Shard
+    {
+        mutex shard_mutex;
+        list<pair<string, string>> entries; // most recently used first
+        unordered_map<string, list<pair<string, string>>::iterator> entryByKey;
+        unsigned long long hits;
+        unsigned long long misses;
+    };
+
+    Shard shards[idCacheShardsNum];
+    volatile size_t maxEntriesPerShard;
+
+    Shard* getShard(const string &key);
+};
+
+#endif // IDCACHE_H
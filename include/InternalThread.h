@@ -2,7 +2,12 @@
 #define INTERNALTHREAD_H
 
 #include <pthread.h>
+#include <atomic>
+#include <memory>
+#include <set>
+#include <list>
 #include "Database.h"
+#include "Scheduler.h"
 #include "OtherServersHandler.h"
 #include "MessageBuilder.h"
 #include "Type9Entry.h"
@@ -18,16 +23,45 @@ public:
     ~InternalThread();
     void start();
     void stopSafely();
+    void tasksReport();
 protected:
 private:
+    struct Worker
+    {
+        InternalThread* internal;
+        TaskGroup group;
+        pthread_t thread;
+    };
+
     volatile bool running;
-    volatile bool stopped;
     Database *db;
     OtherServersHandler *servers;
     MessageBuilder *msgBuilder;
+    Scheduler scheduler;
+    Worker workers[taskGroupsNum];
+    atomic<unsigned int> activeWorkers;
+
+    // shared by the workers
+    TNtrNr tNotaryNr; // own number
+    atomic<bool> upToDate; // written by the maintenance worker
+    shared_ptr<set<unsigned long>> notaries; // relevant notaries, replaced as a whole (atomic_load, atomic_store)
+
+    // used by a single worker
+    unsigned long long reportUpToDateStatusNext;
+    CompleteID pubKeyId;
+    bool pubKeyIsRegistered;
+    CompleteID announcedHeads[5]; // by list type, zero until the first check
+    unsigned long long announcedAt[5];
 
-    pthread_t thread;
-    static void *routine(void *internalThread);
+    static void *routine(void *worker);
+    static void runStatusTasks(InternalThread* internal, unsigned long long currentTime);
+    static void runSynchronizationTasks(InternalThread* internal, unsigned long long currentTime);
+    static void runMaintenanceTasks(InternalThread* internal, unsigned long long currentTime);
+    static bool readyForGatedTasks(InternalThread* internal, TaskGroup group, unsigned long long currentTime);
+    static void runSigningTasks(InternalThread* internal, unsigned long long currentTime);
+    static void storeAndSendSignatures(InternalThread* internal, list<Type13Entry*> &signedEntries, set<unsigned long> &notaries);
+    static bool budgetUsedUp(InternalThread* internal, unsigned long repetitions, unsigned long long runStart);
+    static void runRenotarizationTasks(InternalThread* internal, unsigned long long currentTime);
 };
 
 #endif // INTERNALTHREAD_H
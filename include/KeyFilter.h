@@ -0,0 +1,55 @@
+#ifndef KEYFILTER_H
+#define KEYFILTER_H
+
+#include <string>
+#include <atomic>
+#include <memory>
+#include "rocksdb/slice.h"
+
+#define keyFilterBitsPerKey 10
+#define keyFilterHashesNum 7
+#define keyFilterMinKeys 100000
+#define keyFilterMaxStages 16 // each stage has twice the capacity of the one before
+
+using namespace std;
+
+// bloom filter for the keys of a list which start with prefix and end with suffix,
+// keys are only added (deleted keys remain as possible false positives)
+// new keys go to the latest stage, a full filter is grown by adding a stage (keys of older stages stay)
+class KeyFilter
+{
+public:
+    KeyFilter(const string &pref, const string &suff, size_t expectedKeys);
+    ~KeyFilter();
+    bool covers(const rocksdb::Slice &key);
+    void add(const rocksdb::Slice &key);
+    bool mayContain(const rocksdb::Slice &key);
+    void falsePositive();
+    bool isFull();
+    bool grow();
+    unsigned long long getCapacity();
+    void report(string &msg);
+protected:
+private:
+    struct Stage
+    {
+        size_t bitsNum;
+        unsigned long long capacity;
+        unique_ptr<atomic<unsigned long long>[]> bits;
+        atomic<unsigned long long> keysAdded;
+    };
+
+    const string prefix;
+    const string suffix;
+    Stage* stages[keyFilterMaxStages]; // set before stagesNum is increased, not removed before destruction
+    atomic<size_t> stagesNum;
+    atomic<unsigned long long> keysAdded;
+    atomic<unsigned long long> queries;
+    atomic<unsigned long long> negatives;
+    atomic<unsigned long long> falsePositives;
+
+    Stage* newStage(unsigned long long capacity);
+    void getHashes(const char* data, size_t length, unsigned long long &h1, unsigned long long &h2);
+};
+
+#endif // KEYFILTER_H
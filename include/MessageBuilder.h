@@ -18,6 +18,13 @@
 #include "RefereeInfo.h"
 #include "NotaryInfo.h"
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <limits.h>
+#include <mutex>
+#include <atomic>
+#include <map>
+#include <list>
+#include <vector>
 
 #define maxLong 4294967295
 
@@ -39,8 +46,11 @@ public:
     void sendHeartBeat(int sock);
     void sendAmBanned(int sock);
     void sendPblcKeyInfo(list<Type13Entry*> &t13eList, int sock);
+    void sendPblcKeyInfo(string &t13eListStr, int sock);
     void sendCurrOrOblInfo(list<Type13Entry*> &t13eList, int sock);
+    void sendCurrOrOblInfo(string &t13eListStr, int sock);
     void sendIdInfo(CompleteID &id, list<list<Type13Entry*>*> &listOfT13eLists, int sock);
+    void sendIdInfo(CompleteID &id, list<string> &t13eListsStr, int sock);
     void sendNextClaim(string paramstr, Type14Entry *t14e, int sock);
     void sendClaims(string paramstr, list<list<Type13Entry*>*> &listOfT13eLists, int sock);
     void sendDecThreads(string paramstr, list<list<Type13Entry*>*> &listOfT13eLists, int sock);
@@ -51,7 +61,10 @@ public:
     void sendNewerIds(unsigned char listType, CompleteID id1, CompleteID id2, int sock);
     void sendNotarizationEntry(list<Type13Entry*> &t13eList, int sock);
     void sendNotarizationEntry(list<string> &entriesStr, int sock);
+    bool buildNotarizationEntryMsg(list<Type13Entry*> &t13eList, string &msg);
+    void forgetNotarizationEntry(CompleteID &entryId);
     void sendSignature(string *t13eStr, int sock); // used by non-moderating participants and for clarifications
+    void sendSignature(const char* t13eData, size_t t13eLength, int sock);
     static void packMessage(string *message);
     string* signString(string &strToSign);
     static bool addToString(list<Type13Entry*> &source, string &target);
@@ -68,16 +81,30 @@ private:
     CryptoPP::RSA::PrivateKey *privateKey;
     CryptoPP::AutoSeededRandomPool *rng;
     CryptoPP::RSASS<CryptoPP::PSS, CryptoPP::SHA3_384>::Signer *signer;
+    mutex signer_mutex; // rng and signer are used by request threads and the internal workers
     CompleteID publicKeyID;
     Database *db;
     OtherServersHandler *servers;
 
-    volatile unsigned long long runningID;
+    atomic<unsigned long long> runningID; // ids of signatures made in the same ms by different threads must differ
     string newCompleteIDStr();
 
+    // signed type 17 messages without time stamp (not packed), keyed by entry id and id of last signature
+    struct SignedResponse
+    {
+        string key;
+        string msg;
+        unsigned long long creationTime;
+    };
+    mutex responses_mutex;
+    list<SignedResponse> signedResponses; // most recently used first
+    map<string, list<SignedResponse>::iterator> signedResponsesByKey;
+
     Type13Entry* signEntry(Type13Entry* entry, Type12Entry* uEntry, CompleteID &notPredecessorID, string &newCIDStr);
     Type13Entry* signEntry(Entry* entry);
     static unsigned long addModulo(unsigned long a, unsigned long b);
+    static bool sendPacked(vector<struct iovec> &parts, int sock);
+    static void addPart(vector<struct iovec> &parts, const char* data, size_t length);
     static bool addToString(list<list<Type13Entry*>*> &source, string &target);
 };
 
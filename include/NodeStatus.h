@@ -0,0 +1,37 @@
+#ifndef NODESTATUS_H
+#define NODESTATUS_H
+
+#include <string>
+#include <atomic>
+#include <chrono>
+
+using namespace std;
+
+// status of this notary as needed for accepting requests and signing, recomputed by the internal thread
+// readers do not lock, the status is published as a single word (publish time and flags)
+class NodeStatus
+{
+public:
+    NodeStatus(unsigned long long maxAgeInMs);
+    ~NodeStatus();
+    void publish(bool actingWithBuffer, bool upToDate, unsigned long long currentTime);
+    bool isActingAndUpToDate(); // false if not published recently
+    bool isUpToDate(); // false if not published recently
+    void report(string &msg);
+protected:
+private:
+    enum StatusFlag
+    {
+        flagActingWithBuffer = 1,
+        flagUpToDate = 2,
+        flagsNum = 2 // number of bits used by flags
+    };
+
+    const unsigned long long maxAge;
+    atomic<unsigned long long> status; // publish time in ms shifted by flagsNum, or'ed with flags
+    atomic<unsigned long long> publications;
+
+    unsigned char loadFlags(); // 0 if not published recently
+};
+
+#endif // NODESTATUS_H
@@ -0,0 +1,39 @@
+#ifndef NOTARYTIMELINE_H
+#define NOTARYTIMELINE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <climits>
+
+using namespace std;
+
+// tenure starts of all notaries by lineage, as stored in the notaries list (ULLONG_MAX if not appointed)
+// readers do not lock, writers replace the timeline as a whole (with a new version number)
+class NotaryTimeline
+{
+public:
+    NotaryTimeline();
+    ~NotaryTimeline();
+    void reset(vector<vector<unsigned long long>> &tenureStarts); // lineage i at index i-1
+    void setTenureStart(unsigned short lineageNr, unsigned long notaryNr, unsigned long long tenureStart);
+    unsigned long long getTenureStart(unsigned short lineageNr, unsigned long notaryNr);
+    unsigned long getNotariesCount(unsigned short lineageNr);
+    unsigned long long getVersion();
+    void report(string &msg);
+protected:
+private:
+    typedef vector<unsigned long long> Lineage; // tenure start of notary i at index i-1
+
+    struct Timeline
+    {
+        unsigned long long version;
+        vector<shared_ptr<const Lineage>> lineages;
+    };
+
+    shared_ptr<const Timeline> timeline; // accessed with atomic_load and atomic_store only
+    mutex write_mutex;
+};
+
+#endif // NOTARYTIMELINE_H
@@ -0,0 +1,90 @@
+#ifndef ORDERBOOK_H
+#define ORDERBOOK_H
+
+#include <string>
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <cmath>
+#include "CompleteID.h"
+
+#define orderBookBucketsNum 256
+
+using namespace std;
+
+// exchange offers by (currencyO, currencyR) and by (owner, currencyO, currencyR), sorted by range and ratio
+// writers change the books in place and mark them, publish() makes the marked books visible to readers at once,
+// readers do not lock (snapshot of the bucket with atomic_load)
+class OrderBook
+{
+public:
+    struct Offer
+    {
+        CompleteID id;
+        CompleteID ownerId;
+        CompleteID currencyOId;
+        CompleteID currencyRId;
+        unsigned short range;
+        double ratio;
+        double amountR;
+    };
+
+    OrderBook();
+    ~OrderBook();
+    void add(CompleteID &offerId, CompleteID &ownerId, CompleteID &currencyOId, CompleteID &currencyRId,
+             unsigned short range, double amountR, double ratio);
+    bool remove(CompleteID &offerId);
+    bool setRatio(CompleteID &offerId, double ratio);
+    void publish();
+    bool getOffer(CompleteID &offerId, Offer &target);
+    size_t getOffers(CompleteID &ownerId, CompleteID &currencyOId, CompleteID &currencyRId, unsigned short range,
+                     size_t maxNum, list<CompleteID> &idsList);
+    void clear();
+    void report(string &msg);
+protected:
+private:
+    struct BookKey
+    {
+        CompleteID ownerId; // zero for the book of all owners
+        CompleteID currencyOId;
+        CompleteID currencyRId;
+    };
+
+    struct BookEntry
+    {
+        unsigned short range;
+        double ratio;
+        CompleteID id;
+    };
+
+    struct CompareBookKeys
+    {
+        bool operator()(const BookKey &a, const BookKey &b) const;
+    };
+
+    // same order as the exchange offer keys in the database
+    struct CompareBookEntries
+    {
+        bool operator()(const BookEntry &a, const BookEntry &b) const;
+    };
+
+    typedef set<BookEntry, CompareBookEntries> Book;
+    typedef vector<BookEntry> PublishedBook; // sorted like Book
+    typedef map<BookKey, shared_ptr<const PublishedBook>, CompareBookKeys> Bucket;
+
+    shared_ptr<const Bucket> buckets[orderBookBucketsNum]; // accessed with atomic_load and atomic_store only
+    mutex write_mutex;
+    map<CompleteID, Offer, CompleteID::CompareIDs> offers; // by offer id, guarded by write_mutex
+    map<BookKey, Book, CompareBookKeys> books; // guarded by write_mutex
+    set<BookKey, CompareBookKeys> changedBooks; // not yet published, guarded by write_mutex
+
+    void insert(Offer &offer);
+    void erase(Offer &offer);
+    static size_t getBucket(CompleteID &currencyOId, CompleteID &currencyRId);
+};
+
+#endif // ORDERBOOK_H
@@ -48,6 +48,7 @@ public:
     void sendSignatureToAll(string *t13eStr); // inform everyone
     void sendNotarizationEntryToAll(list<Type13Entry*> &t13eList);
     void sendConsiderNotarizationEntryToAll(CompleteID &firstID);
+    void sendListHeadToAll(unsigned char listType, CompleteID &previousHead, CompleteID &id1, CompleteID &id2);
     void askForInitialType13Entry(CompleteID &id, unsigned long notaryNr);
     void loadContactsReachable(list<unsigned long> &notariesList);
     void sendContactsRqst();
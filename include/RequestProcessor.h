@@ -45,14 +45,21 @@ private:
     void notarizationEntryRequest(const size_t n, byte *request, const int socket);
     void checkNewerEntryRequest(const size_t n, byte *request, const int socket);
     void considerNewerEntriesRequest(const size_t n, byte *request);
+    void listHeadRequest(const size_t n, byte *request);
     void considerNotarizationEntryRequest(const size_t n, byte *request);
     void considerContactInfoRequest(const size_t n, byte *request);
     void contactsRequest(const size_t n, byte *request, const int socket);
     void closeConnectionRequest(const int socket);
     void heartBeatRequest(const int socket);
 
+    void reportNewerEntries(unsigned char listType, unsigned long notaryNr, CompleteID &id1, CompleteID &id2);
+
     bool buildType13Entries(CompleteID &id, list<Type13Entry*> &signaturesList);
+    bool completeType13Entries(CompleteID &id, list<Type13Entry*> &signaturesList);
     bool loadSupportingType13Entries(CompleteID &id, list<Type13Entry*> &target);
+    bool loadSupportingType13Entries(list<CompleteID> &ids, list<list<Type13Entry*>*> &targetLists);
+    bool loadSupportingChains(CompleteID &id, string &target);
+    bool loadSupportingChains(list<CompleteID> &ids, list<string> &targets);
     static void deleteContent(list<Type13Entry*> &entries);
     static void deleteContent(list<list<Type13Entry*>*> &listOfLists);
 };
@@ -0,0 +1,97 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <climits>
+
+using namespace std;
+
+// tasks of the internal thread
+enum SchedulerTask
+{
+    taskSyncWAL,
+    taskPackSignatureLists,
+    taskPersistExchangeOfferRatios,
+    taskUpdateServers,
+    taskCheckNewEntries,
+    taskDownloadNewEntries,
+    taskPublishNodeStatus,
+    taskAnnounceListHeads,
+    taskCheckUpToDateStatus,
+    taskUpdateNotariesList,
+    taskReportContacts,
+    taskSaveCheckpoint,
+    taskGrowKeyFilters,
+    taskCheckThreadTerminations,
+    taskSignEntries,
+    taskUpdateRenotarizationAttempts,
+    taskStartRenotarizations,
+    taskTerminateThreads,
+    taskRegisterKey,
+    tasksNum
+};
+
+// each group is run by its own worker of the internal thread, groups listed first have priority
+enum TaskGroup
+{
+    groupStatus, // short runs only, keeps the published node status fresh, never preempts others
+    groupSigning, // only if well connected, up-to-date and acting
+    groupSynchronization,
+    groupRenotarization, // only if well connected, up-to-date and acting
+    groupMaintenance,
+    taskGroupsNum
+};
+
+// timer queue of the internal thread, other threads can move deadlines forward and wake up the workers
+class Scheduler
+{
+public:
+    Scheduler();
+    ~Scheduler();
+    void scheduleAt(SchedulerTask task, unsigned long long time); // only moves the deadline forward
+    void trigger(SchedulerTask task);
+    void postpone(SchedulerTask task, unsigned long long time); // if due
+    void postponeGroup(TaskGroup group, unsigned long long time); // all due tasks of the group
+    unsigned long long waitForDueTask(TaskGroup group);
+    bool preempted(TaskGroup group);
+    bool isDue(SchedulerTask task, unsigned long long currentTime);
+    void startRun(SchedulerTask task, unsigned long long currentTime);
+    void finishRun(SchedulerTask task, unsigned long long nextTime);
+    void stop();
+    void report(string &msg);
+    static unsigned long long systemTimeInMs();
+    static TaskGroup getGroup(SchedulerTask task);
+protected:
+private:
+    struct TaskStatus
+    {
+        unsigned long long deadline; // ULLONG_MAX if not scheduled
+        chrono::steady_clock::time_point runStart;
+        unsigned long long runs;
+        unsigned long long runTimeTotalInMcrS;
+        unsigned long long runTimeMaxInMcrS;
+        unsigned long long lagTotalInMs; // time between deadline and start of run
+        unsigned long long lagMaxInMs;
+    };
+
+    struct GroupStatus
+    {
+        unsigned int runningTasks;
+        unsigned long long wakeUps;
+        unsigned long long preemptions; // runs interrupted or delayed for groups with higher priority
+    };
+
+    mutex scheduler_mutex;
+    condition_variable wakeUp;
+    TaskStatus tasks[tasksNum];
+    GroupStatus groups[taskGroupsNum];
+    bool stopped;
+
+    unsigned long long earliestDeadline(TaskGroup group); // scheduler_mutex must be locked for this
+    bool higherPriorityWork(TaskGroup group, unsigned long long currentTime); // scheduler_mutex must be locked for this
+};
+
+#endif // SCHEDULER_H
@@ -228,6 +228,76 @@ int main()
         {
             db->upToDateReport();
         }
+        else if (command.compare("tasks")==0)
+        {
+            internal.tasksReport();
+        }
+        else if (command.compare("caches")==0)
+        {
+            db->cachesReport();
+        }
+        else if (command.compare(0, 8, "idcache ")==0)
+        {
+            // usage: idcache <size of each id cache in MB>
+            unsigned long sizeInMb = 0;
+            if (sscanf(command.c_str(), "idcache %lu", &sizeInMb) == 1)
+            {
+                db->setIdCacheSize(sizeInMb);
+                db->cachesReport();
+            }
+            else
+            {
+                puts("usage: idcache <size in MB>");
+            }
+        }
+        else if (command.compare(0, 11, "chaincache ")==0)
+        {
+            // usage: chaincache <size of the cache of serialized supporting entries in MB>
+            unsigned long sizeInMb = 0;
+            if (sscanf(command.c_str(), "chaincache %lu", &sizeInMb) == 1)
+            {
+                db->setChainCacheSize(sizeInMb);
+                db->cachesReport();
+            }
+            else
+            {
+                puts("usage: chaincache <size in MB>");
+            }
+        }
+        else if (command.compare("commits")==0)
+        {
+            db->commitReport();
+        }
+        else if (command.compare(0, 11, "commitmode ")==0)
+        {
+            // usage: commitmode <0: no sync, 1: group sync, 2: sync each write> <max delay in ms>
+            unsigned int mode = 3;
+            unsigned long long maxDelay = 0;
+            if (sscanf(command.c_str(), "commitmode %u %llu", &mode, &maxDelay) == 2 && mode <= 2)
+            {
+                db->setCommitMode((unsigned char) mode, maxDelay);
+                db->commitReport();
+            }
+            else
+            {
+                puts("usage: commitmode <mode> <max delay in ms>");
+            }
+        }
+        else if (command.compare(0, 8, "packing ")==0)
+        {
+            // usage: packing <0: one key per signature, 1: signature lists stored as one value (old lists are converted)>
+            unsigned int on = 2;
+            if (sscanf(command.c_str(), "packing %u", &on) == 1 && on <= 1)
+            {
+                db->lock();
+                db->setSignaturePacking(on == 1);
+                db->unlock();
+            }
+            else
+            {
+                puts("usage: packing <0 or 1>");
+            }
+        }
         else
         {
             puts("unknown command");
@@ -258,6 +328,11 @@ int main()
     while (!noclients);
     servers->stopSafely();
 
+    // keep the state of this run for a warm start
+    db->lock();
+    db->saveCheckpoint();
+    db->unlock();
+
     delete servers;
     delete requests;
     delete db;
@@ -365,16 +440,12 @@ void *socketListener(void *portnr)
         else clients_mutex.unlock();
 
         // pause if this notary is not acting
-        db->lock();
         if (!wantToListen || !db->amCurrentlyActing())
         {
-            db->unlock();
-
             wantToListen = false;
             sleep(1);
             continue;
         }
-        else db->unlock();
 
         // build up connection
         if (!listening)
@@ -425,10 +496,7 @@ void *socketListener(void *portnr)
         }
 
         // check if this notary is banned
-        unsigned long long wellConnectedSince = servers->getWellConnectedSince();
-        db->lock();
-        bool amBanned = !db->amCurrentlyActingWithBuffer() || !db->dbUpToDate(wellConnectedSince);
-        db->unlock();
+        bool amBanned = !db->amActingAndUpToDate();
         if (amBanned) msgBuilder->sendAmBanned(new_socket);
 
         // create and start client thread
@@ -0,0 +1,150 @@
+#include "ChainCache.h"
+
+ChainCache::ChainCache(size_t maxSizeInBytes)
+{
+    for (size_t i=0; i<chainCacheShardsNum; i++)
+    {
+        shards[i].sizeInBytes = 0;
+        shards[i].hits = 0;
+        shards[i].misses = 0;
+        shards[i].staleHits = 0;
+    }
+    setMaxSize(maxSizeInBytes);
+}
+
+ChainCache::~ChainCache()
+{
+    clear();
+}
+
+ChainCache::Shard* ChainCache::getShard(const string &key)
+{
+    return &shards[hash<string>()(key) % chainCacheShardsNum];
+}
+
+size_t ChainCache::entrySize(const CachedChain &entry)
+{
+    return entry.key.length() + entry.stamp.length() + entry.chainStr.length() + chainCacheEntryOverhead;
+}
+
+// shard must be locked for this
+void ChainCache::removeEntry(Shard* shard, list<CachedChain>::iterator it)
+{
+    shard->sizeInBytes -= entrySize(*it);
+    shard->entryByKey.erase(it->key);
+    shard->entries.erase(it);
+}
+
+bool ChainCache::get(CompleteID &id, const string &stamp, string &target)
+{
+    string key = id.to20Char();
+    Shard* shard = getShard(key);
+    shard->shard_mutex.lock();
+    unordered_map<string, list<CachedChain>::iterator>::iterator it = shard->entryByKey.find(key);
+    if (it == shard->entryByKey.end())
+    {
+        shard->misses++;
+        shard->shard_mutex.unlock();
+        return false;
+    }
+    if (it->second->stamp != stamp)
+    {
+        // chain has changed since it was cached
+        shard->staleHits++;
+        removeEntry(shard, it->second);
+        shard->shard_mutex.unlock();
+        return false;
+    }
+    shard->hits++;
+    shard->entries.splice(shard->entries.begin(), shard->entries, it->second);
+    target = it->second->chainStr;
+    shard->shard_mutex.unlock();
+    return true;
+}
+
+void ChainCache::put(CompleteID &id, const string &stamp, const string &chainStr)
+{
+    CachedChain entry;
+    entry.key = id.to20Char();
+    entry.stamp = stamp;
+    entry.chainStr = chainStr;
+    const size_t size = entrySize(entry);
+    if (size > maxBytesPerShard) return;
+    Shard* shard = getShard(entry.key);
+    shard->shard_mutex.lock();
+    unordered_map<string, list<CachedChain>::iterator>::iterator it = shard->entryByKey.find(entry.key);
+    if (it != shard->entryByKey.end()) removeEntry(shard, it->second);
+    shard->entries.push_front(entry);
+    shard->entryByKey.insert(pair<string, list<CachedChain>::iterator>(entry.key, shard->entries.begin()));
+    shard->sizeInBytes += size;
+    while (shard->sizeInBytes > maxBytesPerShard)
+    {
+        removeEntry(shard, --shard->entries.end());
+    }
+    shard->shard_mutex.unlock();
+}
+
+void ChainCache::erase(CompleteID &id)
+{
+    string key = id.to20Char();
+    Shard* shard = getShard(key);
+    shard->shard_mutex.lock();
+    unordered_map<string, list<CachedChain>::iterator>::iterator it = shard->entryByKey.find(key);
+    if (it != shard->entryByKey.end()) removeEntry(shard, it->second);
+    shard->shard_mutex.unlock();
+}
+
+void ChainCache::clear()
+{
+    for (size_t i=0; i<chainCacheShardsNum; i++)
+    {
+        shards[i].shard_mutex.lock();
+        shards[i].entryByKey.clear();
+        shards[i].entries.clear();
+        shards[i].sizeInBytes = 0;
+        shards[i].shard_mutex.unlock();
+    }
+}
+
+// entries above the new limit are removed with the next insertions
+void ChainCache::setMaxSize(size_t maxSizeInBytes)
+{
+    maxBytesPerShard = maxSizeInBytes / chainCacheShardsNum;
+    if (maxBytesPerShard == 0) clear();
+}
+
+void ChainCache::report(string &msg)
+{
+    unsigned long long hits = 0;
+    unsigned long long misses = 0;
+    unsigned long long staleHits = 0;
+    size_t entriesNum = 0;
+    size_t sizeInBytes = 0;
+    for (size_t i=0; i<chainCacheShardsNum; i++)
+    {
+        shards[i].shard_mutex.lock();
+        hits += shards[i].hits;
+        misses += shards[i].misses;
+        staleHits += shards[i].staleHits;
+        entriesNum += shards[i].entries.size();
+        sizeInBytes += shards[i].sizeInBytes;
+        shards[i].shard_mutex.unlock();
+    }
+    msg.append("entries: ");
+    msg.append(to_string(entriesNum));
+    msg.append(", size in KB: ");
+    msg.append(to_string(sizeInBytes / 1024));
+    msg.append(" (max: ");
+    msg.append(to_string(maxBytesPerShard * chainCacheShardsNum / 1024));
+    msg.append("), hits: ");
+    msg.append(to_string(hits));
+    msg.append(", misses: ");
+    msg.append(to_string(misses));
+    msg.append(", outdated: ");
+    msg.append(to_string(staleHits));
+    if (hits+misses+staleHits > 0)
+    {
+        msg.append(", hit rate: ");
+        msg.append(to_string((double) hits / (hits+misses+staleHits)));
+    }
+}
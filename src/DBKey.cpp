@@ -0,0 +1,147 @@
+#include "DBKey.h"
+
+bool DBKey::ownIdLayout = false;
+
+DBKey::DBKey() : len(0), good(true)
+{
+
+}
+
+DBKey::DBKey(char prefix) : len(0), good(true)
+{
+    add(prefix);
+}
+
+DBKey::DBKey(char prefix, CompleteID &id) : len(0), good(true)
+{
+    add(prefix);
+    add(id);
+}
+
+DBKey::DBKey(char prefix, CompleteID &id, const char* suffix) : len(0), good(true)
+{
+    add(prefix);
+    add(id);
+    add(suffix);
+}
+
+void DBKey::add(const char* str, size_t length)
+{
+    if (!good || len + length > dbKeyMaxLength)
+    {
+        good = false;
+        return;
+    }
+    memcpy(data + len, str, length);
+    len += length;
+}
+
+DBKey& DBKey::add(char c)
+{
+    add(&c, 1);
+    return *this;
+}
+
+DBKey& DBKey::add(const char* str)
+{
+    add(str, strlen(str));
+    return *this;
+}
+
+DBKey& DBKey::add(const string &str)
+{
+    add(str.data(), str.length());
+    return *this;
+}
+
+DBKey& DBKey::add(CompleteID &id)
+{
+    if (!ownIdLayout)
+    {
+        string idStr = id.to20Char();
+        add(idStr.data(), idStr.length());
+        return *this;
+    }
+    char idData[dbKeyIdLength];
+    writeId(id, idData);
+    add(idData, dbKeyIdLength);
+    return *this;
+}
+
+void DBKey::truncate(size_t length)
+{
+    if (length < len) len = length;
+}
+
+rocksdb::Slice DBKey::slice() const
+{
+    return rocksdb::Slice(data, len);
+}
+
+size_t DBKey::length() const
+{
+    return len;
+}
+
+bool DBKey::isGood() const
+{
+    return good;
+}
+
+bool DBKey::startsWith(const rocksdb::Slice &key, const DBKey &prefix)
+{
+    return key.starts_with(prefix.slice());
+}
+
+CompleteID DBKey::idAt(const rocksdb::Slice &key, size_t pos)
+{
+    if (key.size() < pos + dbKeyIdLength) return CompleteID();
+    if (!ownIdLayout)
+    {
+        string idStr(key.data() + pos, dbKeyIdLength);
+        return CompleteID(idStr);
+    }
+    return readId(key.data() + pos);
+}
+
+// time stamp, notary and id, each big-endian
+void DBKey::writeId(CompleteID &id, char* out)
+{
+    const unsigned long long timeStamp = id.getTimeStamp();
+    const unsigned long notary = id.getNotary();
+    const unsigned long long idNr = id.getID();
+    for (size_t i=0; i<8; i++) out[i] = (char) (timeStamp >> (8*(7-i)));
+    for (size_t i=0; i<4; i++) out[8+i] = (char) (notary >> (8*(3-i)));
+    for (size_t i=0; i<8; i++) out[12+i] = (char) (idNr >> (8*(7-i)));
+}
+
+CompleteID DBKey::readId(const char* in)
+{
+    const unsigned char* idData = (const unsigned char*) in;
+    unsigned long long timeStamp = 0;
+    unsigned long notary = 0;
+    unsigned long long idNr = 0;
+    for (size_t i=0; i<8; i++) timeStamp = (timeStamp << 8) | idData[i];
+    for (size_t i=0; i<4; i++) notary = (notary << 8) | idData[8+i];
+    for (size_t i=0; i<8; i++) idNr = (idNr << 8) | idData[12+i];
+    return CompleteID(notary, idNr, timeStamp);
+}
+
+// to be called once before keys are built, compares writeId and readId with CompleteID's own serialization
+bool DBKey::checkIdLayout()
+{
+    CompleteID samples[3] = {CompleteID(0, 0, 0), CompleteID(1, 2, 3),
+                             CompleteID(0xA1B2C3D4UL, 0x0102030405060708ULL, 0xF1E2D3C4B5A69788ULL)};
+    bool matches = true;
+    for (size_t i=0; i<3 && matches; i++)
+    {
+        string expected = samples[i].to20Char();
+        char idData[dbKeyIdLength];
+        writeId(samples[i], idData);
+        CompleteID decoded = readId(idData);
+        matches = (expected.length() == dbKeyIdLength && expected.compare(0, dbKeyIdLength, idData, dbKeyIdLength) == 0
+                   && decoded == samples[i]);
+    }
+    ownIdLayout = matches;
+    return matches;
+}
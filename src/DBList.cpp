@@ -0,0 +1,185 @@
+#include "DBList.h"
+
+DBList::DBList(rocksdb::DB* d, rocksdb::ColumnFamilyHandle* h, rocksdb::WriteBatchWithIndex** b)
+    : db(d), handle(h), batch(b), filter(nullptr), prefixLength(0)
+{
+
+}
+
+DBList::~DBList()
+{
+    if (filter != nullptr) delete filter;
+    db->DestroyColumnFamilyHandle(handle);
+}
+
+rocksdb::Status DBList::Put(const rocksdb::WriteOptions& options, const rocksdb::Slice& key, const rocksdb::Slice& value)
+{
+    if (filter != nullptr && filter->covers(key)) filter->add(key);
+    if (*batch != nullptr) return (*batch)->Put(handle, key, value);
+    return db->Put(options, handle, key, value);
+}
+
+rocksdb::Status DBList::Get(const rocksdb::ReadOptions& options, const rocksdb::Slice& key, string* value)
+{
+    if (*batch != nullptr) return (*batch)->GetFromBatchAndDB(db, options, handle, key, value);
+    return db->Get(options, handle, key, value);
+}
+
+// the value stays valid until it is reset or destroyed, without being copied (if not in the write batch)
+rocksdb::Status DBList::Get(const rocksdb::ReadOptions& options, const rocksdb::Slice& key, rocksdb::PinnableSlice* value)
+{
+    if (*batch != nullptr) return (*batch)->GetFromBatchAndDB(db, options, handle, key, value);
+    return db->Get(options, handle, key, value);
+}
+
+vector<rocksdb::Status> DBList::MultiGet(const rocksdb::ReadOptions& options, const vector<rocksdb::Slice>& keys, vector<string>* values)
+{
+    if (*batch == nullptr)
+    {
+        vector<rocksdb::ColumnFamilyHandle*> handles(keys.size(), handle);
+        return db->MultiGet(options, handles, keys, values);
+    }
+    // write batch has no MultiGet
+    vector<rocksdb::Status> out;
+    values->clear();
+    values->resize(keys.size());
+    for (size_t i=0; i<keys.size(); i++)
+    {
+        out.push_back((*batch)->GetFromBatchAndDB(db, options, handle, keys[i], &(*values)[i]));
+    }
+    return out;
+}
+
+rocksdb::Status DBList::Delete(const rocksdb::WriteOptions& options, const rocksdb::Slice& key)
+{
+    if (*batch != nullptr) return (*batch)->Delete(handle, key);
+    return db->Delete(options, handle, key);
+}
+
+// iterates in total order, also across different prefixes
+rocksdb::Iterator* DBList::NewIterator(const rocksdb::ReadOptions& options)
+{
+    rocksdb::ReadOptions readOptions(options);
+    if (prefixLength > 0 && !readOptions.prefix_same_as_start) readOptions.total_order_seek = true;
+    if (*batch != nullptr) return (*batch)->NewIteratorWithBase(handle, db->NewIterator(readOptions, handle));
+    return db->NewIterator(readOptions, handle);
+}
+
+// iterates over keys starting with prefix only (without an active write batch, the end of the range is checked by rocksdb)
+rocksdb::Iterator* DBList::NewPrefixIterator(const rocksdb::Slice& prefix)
+{
+    // upper bound: prefix with last byte incremented
+    string bound = prefix.ToString();
+    while (!bound.empty() && (unsigned char) bound.back() == 0xFF) bound.pop_back();
+    if (!bound.empty()) bound.back() = (char) ((unsigned char) bound.back() + 1);
+    BoundedIterator* out = new BoundedIterator(bound);
+
+    rocksdb::ReadOptions readOptions;
+    if (!bound.empty()) readOptions.iterate_upper_bound = out->getBound();
+    if (prefixLength > 0)
+    {
+        if (prefix.size() >= prefixLength) readOptions.prefix_same_as_start = true;
+        else readOptions.total_order_seek = true;
+    }
+    if (*batch != nullptr) out->setIterator((*batch)->NewIteratorWithBase(handle, db->NewIterator(readOptions, handle)));
+    else out->setIterator(db->NewIterator(readOptions, handle));
+    return out;
+}
+
+bool DBList::GetProperty(const rocksdb::Slice& property, string* value)
+{
+    return db->GetProperty(handle, property, value);
+}
+
+rocksdb::ColumnFamilyHandle* DBList::getHandle()
+{
+    return handle;
+}
+
+// the list takes ownership of the filter
+void DBList::setFilter(KeyFilter* f)
+{
+    if (filter != nullptr) delete filter;
+    filter = f;
+}
+
+KeyFilter* DBList::getFilter()
+{
+    return filter;
+}
+
+// to be set according to the prefix extractor of the column family
+void DBList::setPrefixLength(size_t length)
+{
+    prefixLength = length;
+}
+
+BoundedIterator::BoundedIterator(const string &bound) : upperBound(bound), upperBoundSlice(upperBound), it(nullptr)
+{
+
+}
+
+BoundedIterator::~BoundedIterator()
+{
+    if (it != nullptr) delete it;
+}
+
+void BoundedIterator::setIterator(rocksdb::Iterator* i)
+{
+    it = i;
+}
+
+const rocksdb::Slice* BoundedIterator::getBound()
+{
+    return &upperBoundSlice;
+}
+
+bool BoundedIterator::Valid() const
+{
+    return it->Valid();
+}
+
+void BoundedIterator::SeekToFirst()
+{
+    it->SeekToFirst();
+}
+
+void BoundedIterator::SeekToLast()
+{
+    it->SeekToLast();
+}
+
+void BoundedIterator::Seek(const rocksdb::Slice& target)
+{
+    it->Seek(target);
+}
+
+void BoundedIterator::SeekForPrev(const rocksdb::Slice& target)
+{
+    it->SeekForPrev(target);
+}
+
+void BoundedIterator::Next()
+{
+    it->Next();
+}
+
+void BoundedIterator::Prev()
+{
+    it->Prev();
+}
+
+rocksdb::Slice BoundedIterator::key() const
+{
+    return it->key();
+}
+
+rocksdb::Slice BoundedIterator::value() const
+{
+    return it->value();
+}
+
+rocksdb::Status BoundedIterator::status() const
+{
+    return it->status();
+}
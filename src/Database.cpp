@@ -4,13 +4,46 @@
 #define maxEntriesToDownload 1000
 #define maxDownloadAttempts 5
 #define minUpToDateTimeBufferInMs 7000
-#define participationTimeBufferInMs 250
+#define participationTimeBufferInMs 250 // delay between the leading signer and each fallback signer
 #define minTimeBetweenDownloadAttemptsInMs 3000
 #define blockCacheSizeInMb 150
 #define writeBufferSizeInMb 16
+#define smallWriteBufferSizeInMb 4
+#define totalWriteBufferSizeInMb 128
+#define migrationBatchSize 10000
+#define defaultCommitMode 1
+#define defaultMaxCommitDelayInMs 20
+#define idCacheSizeInMb 16 // for each of the two id caches
+#define chainCacheSizeInMb 64
+#define defaultPackSignatureLists true // store new signature lists as one value (SP) instead of SLH + SLB<i>
+#define exchangeOfferKeyLength 93 // 'I' + owner + "EO" + currencyO + currencyR + range + ratio + offer id
+#define packingScanLimit 5000 // keys looked at per call of packNextSignatureLists
+#define packingCursorKey "K" // in scheduledActions: next key to check for signature lists to pack
+#define packingDoneMarker "done" // value of packingCursorKey once all lists are packed
+#define claimsIndexKey "MCI" // marks that the claims index has been built
+#define maxCheckpointAgeInMs 600000 // entries to sign and to download of older checkpoints are not restored
+#define maxNodeStatusAgeInMs 2000 // an older published status counts as not acting and not up-to-date
+
+Database::Database(const string& dbDir) : writeBatch(nullptr), writeBatchDepth(0),
+    firstIdCache(idCacheSizeInMb * 1024 * 1024LL), latestIdCache(idCacheSizeInMb * 1024 * 1024LL),
+    chainCache(chainCacheSizeInMb * 1024 * 1024LL), nodeStatus(maxNodeStatusAgeInMs),
+    commitMode(defaultCommitMode), maxCommitDelayInMs(defaultMaxCommitDelayInMs), nextWalSyncTime(ULLONG_MAX),
+    firstUnsyncedTime(0), unsyncedBatches(0), committedBatches(0), committedKeys(0), commitTimeTotalInMcrS(0),
+    commitTimeMaxInMcrS(0), walSyncs(0), syncedBatches(0), syncTimeTotalInMcrS(0), syncTimeMaxInMcrS(0), syncDelayTotalInMs(0),
+    ownNumber(0), packSignatureLists(defaultPackSignatureLists), packedListsCount(0),
+    downloads(maxEntriesToDownload, minTimeBetweenDownloadAttemptsInMs),
+    nextSigningTime(ULLONG_MAX), scheduler(nullptr)
+{
+    // waiting writers take precedence over new readers
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(&db_rwlock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+
+    // keys are built without CompleteID::to20Char() if the layout is confirmed
+    if (!DBKey::checkIdLayout()) puts("Database: id layout of DBKey differs from CompleteID, to20Char() is used.");
 
-Database::Database(const string& dbDir) : ownNumber(0)
-{
     // loading type 1 entry
     type1entry=new Type1Entry(dbDir+"/type1entry");
     if (!type1entry->isGood())
@@ -19,137 +52,468 @@ Database::Database(const string& dbDir) : ownNumber(0)
         return;
     }
 
-    // options for rocksdb
+    // options for rocksdb (block cache and write buffers are shared by all lists)
     table_options.block_cache = rocksdb::NewLRUCache(blockCacheSizeInMb * 1024 * 1024LL);
     table_options.cache_index_and_filter_blocks = true;
     table_options.pin_l0_filter_and_index_blocks_in_cache = true;
-    rocksdb::Options options;
-    options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
-    options.optimize_filters_for_hits = true;
-    options.write_buffer_size = writeBufferSizeInMb * 1024 * 1024LL;
-    options.db_write_buffer_size = writeBufferSizeInMb * 1024 * 1024LL;
-    options.max_write_buffer_number = 3;
-    options.create_if_missing = true;
-
-    rocksdb::Status status;
-
-    // loading notaries list
-    status = rocksdb::DB::Open(options, dbDir+"/notaries", &notaries);
+    table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10, false));
+    rocksdb::DBOptions dbOptions;
+    dbOptions.create_if_missing = true;
+    dbOptions.create_missing_column_families = true;
+    dbOptions.write_buffer_manager = make_shared<rocksdb::WriteBufferManager>(
+                                         totalWriteBufferSizeInMb * 1024 * 1024LL, table_options.block_cache);
+
+    // the lists of the database, each one stored as a column family
+    const size_t listsCount = 12;
+    const string listNames[listsCount] = {"notaries", "entriesInNotarization", "notarizationEntries", "publicKeys",
+                                          "subjectToRenotarization", "notaryApplications", "currenciesAndObligations",
+                                          "scheduledActions", "essentialEntries", "conflicts", "perpetualEntries",
+                                          "transfersWithFees"
+                                         };
+    DBList** lists[listsCount] = {&notaries, &entriesInNotarization, &notarizationEntries, &publicKeys,
+                                  &subjectToRenotarization, &notaryApplications, &currenciesAndObligations,
+                                  &scheduledActions, &essentialEntries, &conflicts, &perpetualEntries,
+                                  &transfersWithFees
+                                 };
+
+    vector<rocksdb::ColumnFamilyDescriptor> descriptors;
+    descriptors.push_back(rocksdb::ColumnFamilyDescriptor(rocksdb::kDefaultColumnFamilyName, rocksdb::ColumnFamilyOptions()));
+    for (size_t i=0; i<listsCount; i++)
+    {
+        descriptors.push_back(rocksdb::ColumnFamilyDescriptor(listNames[i], getListOptions(listNames[i])));
+    }
+
+    // loading lists
+    vector<rocksdb::ColumnFamilyHandle*> handles;
+    rocksdb::Status status = rocksdb::DB::Open(dbOptions, dbDir+"/lists", descriptors, &handles, &listsDB);
     if (!status.ok())
     {
-        puts("List of notaries could not be loaded.");
+        puts("Database lists could not be loaded.");
+        puts(status.ToString().c_str());
         return;
     }
-
-    // loading entriesInNotarization
-    status = rocksdb::DB::Open(options, dbDir+"/entriesInNotarization", &entriesInNotarization);
-    if (!status.ok())
+    listsDB->DestroyColumnFamilyHandle(handles[0]); // default column family is not used
+    for (size_t i=0; i<listsCount; i++)
     {
-        puts("List of entries in notarization could not be loaded.");
-        return;
+        *lists[i] = new DBList(listsDB, handles[i+1], &writeBatch);
+        (*lists[i])->setPrefixLength(getListPrefixLength(listNames[i]));
     }
 
-    // loading notarizationEntries
-    status = rocksdb::DB::Open(options, dbDir+"/notarizationEntries", &notarizationEntries);
-    if (!status.ok())
+    // move content of lists from old separate databases (if existent)
+    for (size_t i=0; i<listsCount; i++)
     {
-        puts("General list of notarization entries could not be loaded.");
-        return;
+        if (!migrateOldList(dbDir+"/"+listNames[i], *lists[i], descriptors[i+1].options))
+        {
+            puts("Database: migration of old list failed.");
+            puts(listNames[i].c_str());
+            return;
+        }
     }
 
-    // loading publicKeys
-    status = rocksdb::DB::Open(options, dbDir+"/publicKeys", &publicKeys);
-    if (!status.ok())
+    // filters for lookups which are expected to fail most of the time
+    initKeyFilter(notarizationEntries, "B", "FN"); // general list
+    initKeyFilter(publicKeys, "B", ""); // public keys by byte sequence
+    initKeyFilter(currenciesAndObligations, "B", ""); // currencies and obligations by byte sequence
+    initKeyFilter(conflicts, "", "");
+
+    // index claims of databases created before the index existed
+    buildClaimsIndex();
+
+    // load exchange offers into memory
+    initOrderBook();
+
+    // convert old signature lists in the background, continuing where the last run stopped
+    if (packSignatureLists)
     {
-        puts("List of public Kkeys could not be loaded.");
-        return;
+        string value;
+        rocksdb::Status s = scheduledActions->Get(rocksdb::ReadOptions(), packingCursorKey, &value);
+        if (!s.ok() || value.length()<=2) packingCursor = "B";
+        else if (value.compare(packingDoneMarker)==0) packingCursor.clear();
+        else packingCursor = value;
     }
 
-    // loading subjectToRenotarization
-    status = rocksdb::DB::Open(options, dbDir+"/subjectToRenotarization", &subjectToRenotarization);
-    if (!status.ok())
+    puts("Database loaded successfully.");
+}
+
+// db must be locked for this
+void Database::beginWriteBatch()
+{
+    writeBatchDepth++;
+    if (writeBatch != nullptr) return;
+    // overwrite_key is needed for iterators over batch and db
+    writeBatch = new rocksdb::WriteBatchWithIndex(rocksdb::BytewiseComparator(), 0, true);
+}
+
+// db must be locked for this
+bool Database::commitWriteBatch()
+{
+    if (writeBatchDepth == 0 || writeBatch == nullptr) return false;
+    writeBatchDepth--;
+    if (writeBatchDepth > 0) return true;
+    rocksdb::WriteBatchWithIndex* batch = writeBatch;
+    writeBatch = nullptr;
+    bool success = true;
+    const unsigned long keysCount = batch->GetWriteBatch()->Count();
+    if (keysCount > 0)
     {
-        puts("List of entries subject to renotarization could not be loaded.");
-        return;
+        rocksdb::WriteOptions writeOptions;
+        writeOptions.sync = (commitMode == 2);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        rocksdb::Status s = listsDB->Write(writeOptions, batch->GetWriteBatch());
+        unsigned long long duration = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+        if (!s.ok())
+        {
+            puts("Database: write batch could not be committed.");
+            puts(s.ToString().c_str());
+            success = false;
+            // caches might contain values from the batch
+            firstIdCache.clear();
+            latestIdCache.clear();
+            chainCache.clear();
+            reloadExchangeOffers();
+            rebuildNotaryTimeline();
+            loadDeadlineIndexes();
+            if (scheduler != nullptr) scheduler->trigger(taskCheckThreadTerminations);
+        }
+        commitStats_mutex.lock();
+        committedBatches++;
+        committedKeys+=keysCount;
+        commitTimeTotalInMcrS+=duration;
+        if (duration > commitTimeMaxInMcrS) commitTimeMaxInMcrS = duration;
+        if (success && commitMode == 1)
+        {
+            if (unsyncedBatches == 0)
+            {
+                firstUnsyncedTime = systemTimeInMs();
+                nextWalSyncTime = firstUnsyncedTime + maxCommitDelayInMs;
+                if (scheduler != nullptr) scheduler->scheduleAt(taskSyncWAL, nextWalSyncTime);
+            }
+            unsyncedBatches++;
+        }
+        commitStats_mutex.unlock();
     }
+    exchangeOffersInBatch.clear();
+    orderBook.publish();
+    delete batch;
+    return success;
+}
 
-    // loading notaryApplications
-    status = rocksdb::DB::Open(options, dbDir+"/notaryApplications", &notaryApplications);
-    if (!status.ok())
+// can be called without locking the db
+unsigned long long Database::getNextWalSyncTime()
+{
+    return nextWalSyncTime;
+}
+
+// one WAL sync for all batches committed since the last sync, can be called without locking the db
+void Database::syncWAL()
+{
+    commitStats_mutex.lock();
+    const unsigned long long batches = unsyncedBatches;
+    const unsigned long long firstTime = firstUnsyncedTime;
+    unsyncedBatches = 0;
+    nextWalSyncTime = ULLONG_MAX;
+    commitStats_mutex.unlock();
+    if (batches == 0) return;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    rocksdb::Status s = listsDB->SyncWAL();
+    unsigned long long duration = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+    if (!s.ok())
     {
-        puts("List of notary applications could not be loaded.");
-        return;
+        puts("Database: WAL sync failed.");
+        puts(s.ToString().c_str());
     }
 
-    // loading currenciesAndObligations
-    status = rocksdb::DB::Open(options, dbDir+"/currenciesAndObligations", &currenciesAndObligations);
-    if (!status.ok())
+    commitStats_mutex.lock();
+    walSyncs++;
+    syncedBatches+=batches;
+    syncTimeTotalInMcrS+=duration;
+    if (duration > syncTimeMaxInMcrS) syncTimeMaxInMcrS = duration;
+    syncDelayTotalInMs+=systemTimeInMs()-firstTime;
+    commitStats_mutex.unlock();
+}
+
+void Database::setCommitMode(unsigned char mode, unsigned long long maxDelayInMs)
+{
+    if (mode > 2) return;
+    commitStats_mutex.lock();
+    commitMode = mode;
+    maxCommitDelayInMs = maxDelayInMs;
+    if (unsyncedBatches > 0)
     {
-        puts("List of currencies and obligations could not be loaded.");
-        return;
+        nextWalSyncTime = firstUnsyncedTime + maxDelayInMs;
+        if (scheduler != nullptr) scheduler->scheduleAt(taskSyncWAL, nextWalSyncTime);
     }
+    commitStats_mutex.unlock();
+    // batches written in an earlier mode are synced with the next call of syncWAL
+    if (mode != 1) syncWAL();
+}
 
-    // loading scheduledActions
-    status = rocksdb::DB::Open(options, dbDir+"/scheduledActions", &scheduledActions);
-    if (!status.ok())
+// db must be locked for this
+// lists stored unpacked in the meantime are converted by a new scan after packing is switched on again
+void Database::setSignaturePacking(bool on)
+{
+    if (on == packSignatureLists) return;
+    packSignatureLists = on;
+    if (on)
     {
-        puts("List of scheduled Actions could not be loaded.");
-        return;
+        packingCursor = "B";
+        packedListsCount = 0;
+        if (scheduler != nullptr) scheduler->trigger(taskPackSignatureLists);
+        puts("Database: signature lists are stored packed, converting old lists ...");
+    }
+    else
+    {
+        packingCursor.clear();
+        scheduledActions->Delete(rocksdb::WriteOptions(), packingCursorKey);
+        puts("Database: signature lists are stored as one key per signature.");
     }
+}
 
-    // loading essentialEntries
-    status = rocksdb::DB::Open(options, dbDir+"/essentialEntries", &essentialEntries);
-    if (!status.ok())
+// the scheduler is told about new entries to sign or download and about pending WAL syncs
+void Database::setScheduler(Scheduler* s)
+{
+    scheduler = s;
+}
+
+void Database::setIdCacheSize(size_t sizeInMb)
+{
+    firstIdCache.setMaxSize(sizeInMb * 1024 * 1024LL);
+    latestIdCache.setMaxSize(sizeInMb * 1024 * 1024LL);
+}
+
+void Database::setChainCacheSize(size_t sizeInMb)
+{
+    chainCache.setMaxSize(sizeInMb * 1024 * 1024LL);
+}
+
+void Database::cachesReport()
+{
+    string msg("First id cache: ");
+    firstIdCache.report(msg);
+    msg.append("\nOrder book: ");
+    orderBook.report(msg);
+    msg.append("\nLatest id cache: ");
+    latestIdCache.report(msg);
+    msg.append("\nChain cache: ");
+    chainCache.report(msg);
+    msg.append("\nNotary timeline: ");
+    notaryTimeline.report(msg);
+    msg.append("\nExpected terminations: ");
+    expectedTerminations.report(msg);
+    msg.append("\nRenotarization subjects: ");
+    renotarizationSubjects.report(msg);
+    msg.append("\nRenotarization attempts: ");
+    renotarizationAttempts.report(msg);
+    msg.append("\nNode status: ");
+    nodeStatus.report(msg);
+    const size_t filtersNum = 4;
+    const char* filterNames[filtersNum] = {"general list", "public keys", "currencies and obligations", "conflicts"};
+    DBList* filteredLists[filtersNum] = {notarizationEntries, publicKeys, currenciesAndObligations, conflicts};
+    for (size_t i=0; i<filtersNum; i++)
     {
-        puts("List of essential Entries could not be loaded.");
-        return;
+        KeyFilter* filter = filteredLists[i]->getFilter();
+        if (filter == nullptr) continue;
+        msg.append("\nKey filter (");
+        msg.append(filterNames[i]);
+        msg.append("): ");
+        filter->report(msg);
     }
+    puts(msg.c_str());
+}
 
-    // loading conflicts
-    status = rocksdb::DB::Open(options, dbDir+"/conflicts", &conflicts);
-    if (!status.ok())
+void Database::commitReport()
+{
+    commitStats_mutex.lock();
+    string msg("Commit mode: ");
+    msg.append(to_string(commitMode));
+    msg.append(" (max delay in ms: ");
+    msg.append(to_string(maxCommitDelayInMs));
+    msg.append(")\nCommitted batches: ");
+    msg.append(to_string(committedBatches));
+    msg.append("\n  Keys written: ");
+    msg.append(to_string(committedKeys));
+    if (committedBatches > 0)
+    {
+        msg.append("\n  Avg. write time in mcrs: ");
+        msg.append(to_string(commitTimeTotalInMcrS / committedBatches));
+    }
+    msg.append("\n  Max. write time in mcrs: ");
+    msg.append(to_string(commitTimeMaxInMcrS));
+    msg.append("\nWAL syncs: ");
+    msg.append(to_string(walSyncs));
+    if (walSyncs > 0)
+    {
+        msg.append("\n  Avg. batches per sync: ");
+        msg.append(to_string((double) syncedBatches / walSyncs));
+        msg.append("\n  Avg. sync time in mcrs: ");
+        msg.append(to_string(syncTimeTotalInMcrS / walSyncs));
+        msg.append("\n  Avg. delay until sync in ms: ");
+        msg.append(to_string(syncDelayTotalInMs / walSyncs));
+    }
+    msg.append("\n  Max. sync time in mcrs: ");
+    msg.append(to_string(syncTimeMaxInMcrS));
+    msg.append("\n  Batches waiting for sync: ");
+    msg.append(to_string(unsyncedBatches));
+    commitStats_mutex.unlock();
+    puts(msg.c_str());
+}
+
+void Database::initKeyFilter(DBList* dbList, const string &prefix, const string &suffix)
+{
+    // sized by the estimated number of keys in the whole list, grown by growKeyFilters() later on
+    size_t keysNum = 0;
+    string value;
+    if (dbList->GetProperty("rocksdb.estimate-num-keys", &value)) keysNum = strtoull(value.c_str(), nullptr, 10);
+    KeyFilter* filter = new KeyFilter(prefix, suffix, keysNum);
+    rocksdb::Iterator* it = dbList->NewPrefixIterator(prefix);
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next())
     {
-        puts("List of conflicts could not be loaded.");
-        return;
+        if (filter->covers(it->key())) filter->add(it->key());
     }
+    delete it;
+    dbList->setFilter(filter);
+}
 
-    // loading perpetuals
-    status = rocksdb::DB::Open(options, dbDir+"/perpetualEntries", &perpetualEntries);
-    if (!status.ok())
+// adds a stage to filters which received more keys than they were sized for, can be called without locking the db
+void Database::growKeyFilters()
+{
+    const size_t filtersNum = 4;
+    const char* filterNames[filtersNum] = {"general list", "public keys", "currencies and obligations", "conflicts"};
+    DBList* filteredLists[filtersNum] = {notarizationEntries, publicKeys, currenciesAndObligations, conflicts};
+    for (size_t i=0; i<filtersNum; i++)
     {
-        puts("List of perpetual Entries could not be loaded.");
-        return;
+        KeyFilter* filter = filteredLists[i]->getFilter();
+        if (filter == nullptr || !filter->isFull() || !filter->grow()) continue;
+        string msg("Database: key filter (");
+        msg.append(filterNames[i]);
+        msg.append(") grown to a capacity of ");
+        msg.append(to_string(filter->getCapacity()));
+        puts(msg.c_str());
     }
+}
 
-    // loading transfers
-    status = rocksdb::DB::Open(options, dbDir+"/transfersWithFees", &transfersWithFees);
-    if (!status.ok())
+// adds 'I' + owner + 'C' + currency + 'I' + claim id for each claim stored as 'I' + owner + 'C' + currency + 'B' + k
+void Database::buildClaimsIndex()
+{
+    string value;
+    rocksdb::Status s = publicKeys->Get(rocksdb::ReadOptions(), claimsIndexKey, &value);
+    if (s.ok() && value.length()>2) return;
+    puts("Database: building claims index ...");
+    list<pair<string, string>> indexEntries;
+    rocksdb::Iterator* it = publicKeys->NewPrefixIterator("I");
+    for (it->Seek("I"); it->Valid(); it->Next())
+    {
+        rocksdb::Slice keySlice = it->key();
+        if (keySlice.size()!=51 || keySlice[21]!='C' || keySlice[42]!='B' || it->value().size()!=dbKeyIdLength) continue;
+        string key(keySlice.data(), 42);
+        key.push_back('I'); // suffix for claims by id
+        key.append(it->value().ToString());
+        indexEntries.push_back(pair<string, string>(key, it->value().ToString()));
+    }
+    delete it;
+    size_t c = 0;
+    list<pair<string, string>>::iterator iter = indexEntries.begin();
+    while (iter!=indexEntries.end())
     {
-        puts("List of transfers With Fees could not be loaded.");
-        return;
+        WriteBatchScope batchScope(this);
+        for (c=0; c<migrationBatchSize && iter!=indexEntries.end(); c++, ++iter)
+        {
+            publicKeys->Put(rocksdb::WriteOptions(), iter->first, iter->second);
+        }
     }
+    publicKeys->Put(rocksdb::WriteOptions(), claimsIndexKey, util.UlAsByteSeq(1));
+    string msg("Database: claims indexed: ");
+    msg.append(to_string(indexEntries.size()));
+    puts(msg.c_str());
+}
 
-    puts("Database loaded successfully.");
+// lists whose scans mostly start with 'I' + id (public keys, currencies and obligations)
+// use that part of the key for prefix bloom filters
+size_t Database::getListPrefixLength(const string &listName)
+{
+    if (listName.compare("publicKeys")==0 || listName.compare("currenciesAndObligations")==0) return 21;
+    return 0;
 }
 
-void Database::upToDateReport()
+// per list tuning, lists with many and long living keys get larger write buffers
+rocksdb::ColumnFamilyOptions Database::getListOptions(const string &listName)
 {
-    lock();
-    string msg;
-    msg.append("entriesToDownload: ");
-    msg.append(to_string(((map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>*)entriesToDownload)->size()));
+    rocksdb::ColumnFamilyOptions cfOptions;
+    cfOptions.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+    cfOptions.optimize_filters_for_hits = true;
+    const size_t prefixLength = getListPrefixLength(listName);
+    if (prefixLength > 0)
+    {
+        cfOptions.prefix_extractor.reset(rocksdb::NewFixedPrefixTransform(prefixLength));
+        cfOptions.memtable_prefix_bloom_size_ratio = 0.02;
+    }
+    if (listName.compare("notarizationEntries")==0 || listName.compare("publicKeys")==0
+            || listName.compare("currenciesAndObligations")==0)
+    {
+        cfOptions.write_buffer_size = writeBufferSizeInMb * 1024 * 1024LL;
+        cfOptions.max_write_buffer_number = 3;
+    }
+    else
+    {
+        cfOptions.write_buffer_size = smallWriteBufferSizeInMb * 1024 * 1024LL;
+        cfOptions.max_write_buffer_number = 2;
+    }
+    return cfOptions;
+}
 
-    msg.append("\nentriesInDownload: ");
-    msg.append(to_string(((map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>*)entriesInDownload)->size()));
+// one-shot migration of a list stored in a separate database (as in older versions)
+bool Database::migrateOldList(const string& oldDir, DBList* target, rocksdb::ColumnFamilyOptions &cfOptions)
+{
+    rocksdb::Env* env = rocksdb::Env::Default();
+    if (!env->FileExists(oldDir+"/CURRENT").ok()) return true;
 
-    msg.append("\nmissingPredecessors: ");
-    msg.append(to_string(missingPredecessors.size()));
+    string msg("Database: migrating ");
+    msg.append(oldDir);
+    puts(msg.c_str());
 
-    msg.append("\nmissingNotaries: ");
-    msg.append(to_string(missingNotaries.size()));
+    rocksdb::Options options(rocksdb::DBOptions(), cfOptions);
+    rocksdb::DB* oldDB;
+    rocksdb::Status s = rocksdb::DB::OpenForReadOnly(options, oldDir, &oldDB);
+    if (!s.ok()) return false;
+    // copy in chunks
+    rocksdb::WriteBatch batch;
+    size_t count = 0;
+    rocksdb::Iterator* it = oldDB->NewIterator(rocksdb::ReadOptions());
+    for (it->SeekToFirst(); it->Valid(); it->Next())
+    {
+        batch.Put(target->getHandle(), it->key(), it->value());
+        count++;
+        if (batch.Count() >= migrationBatchSize)
+        {
+            s = listsDB->Write(rocksdb::WriteOptions(), &batch);
+            if (!s.ok()) break;
+            batch.Clear();
+        }
+    }
+    bool success = it->status().ok() && s.ok();
+    delete it;
+    delete oldDB;
+    if (!success) return false;
+    rocksdb::WriteOptions writeOptions;
+    writeOptions.sync = true;
+    s = listsDB->Write(writeOptions, &batch);
+    if (!s.ok()) return false;
+    // keep old database, but make sure it is not migrated again
+    s = env->RenameFile(oldDir, oldDir+".migrated");
+    if (!s.ok()) return false;
+
+    msg = "Database: keys migrated: ";
+    msg.append(to_string(count));
+    puts(msg.c_str());
+    return true;
+}
 
-    msg.append("\nsize of lastDownloadAttempt: ");
-    msg.append(to_string(lastDownloadAttempt.size()));
+void Database::upToDateReport()
+{
+    lock();
+    string msg;
+    downloads.report(msg);
 
     msg.append("\nsize of entriesToSign: ");
     msg.append(to_string(entriesToSign.size()));
@@ -183,8 +547,13 @@ void Database::rocksdbReport()
     msg.append("\n  Pinned usage: ");
     msg.append(to_string(table_options.block_cache->GetPinnedUsage()));
 
-    msg.append("\nIndex and filter blocks (notaries): ");
+    msg.append("\nWrite buffers (all lists): ");
     string out;
+    listsDB->GetProperty("rocksdb.cur-size-all-mem-tables", &out);
+    msg.append(out);
+
+    msg.append("\nIndex and filter blocks (notaries): ");
+    out.clear();
     notaries->GetProperty("rocksdb.estimate-table-readers-mem", &out);
     msg.append(out);
 
@@ -309,6 +678,12 @@ bool Database::init(unsigned long ownNr, TNtrNr corrNotary, CryptoPP::RSA::Publi
         }
     }
 
+    // load tenure starts of all notaries into memory
+    rebuildNotaryTimeline();
+
+    // load scheduled thread terminations and renotarizations into memory
+    loadDeadlineIndexes();
+
     // initialize UpToDateTimeInfo
     puts("initializing UpToDateTimeInfo");
     listEssentials = new UpToDateTimeInfo(loadUpToDateID(0));
@@ -340,14 +715,163 @@ bool Database::init(unsigned long ownNr, TNtrNr corrNotary, CryptoPP::RSA::Publi
     notariesSet->clear();
     delete notariesSet;
 
-    entriesToDownload = new map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>();
-    entriesInDownload = new map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>();
+    // restore state of the last run
+    loadCheckpoint();
 
     unlock();
 
     return true;
 }
 
+// db must be locked for this
+// entries to sign, entries to download and individual up-to-date ids, stored in scheduledActions (C)
+void Database::saveCheckpoint()
+{
+    WriteBatchScope batchScope(this); // all parts are written at once
+    string key("CT"); // time of checkpoint
+    scheduledActions->Put(rocksdb::WriteOptions(), key, util.UllAsByteSeq(systemTimeInMs()));
+
+    string value;
+    set<pair<unsigned long long,CompleteID>, CompleteID::LLComparePairs>::iterator it;
+    for (it=entriesToSign.begin(); it!=entriesToSign.end(); ++it)
+    {
+        CompleteID id = it->second;
+        value.append(util.UllAsByteSeq(it->first));
+        value.append(id.to20Char());
+    }
+    key="CS"; // entries to sign
+    scheduledActions->Put(rocksdb::WriteOptions(), key, value);
+
+    map<CompleteID, set<pair<unsigned char,unsigned long>>, CompleteID::CompareIDs> entriesToDownload;
+    downloads.loadEntries(entriesToDownload);
+    value="";
+    map<CompleteID, set<pair<unsigned char,unsigned long>>, CompleteID::CompareIDs>::iterator it2;
+    for (it2=entriesToDownload.begin(); it2!=entriesToDownload.end(); ++it2)
+    {
+        CompleteID id = it2->first;
+        value.append(id.to20Char());
+        value.append(util.UlAsByteSeq(it2->second.size()));
+        set<pair<unsigned char,unsigned long>>::iterator it3;
+        for (it3=it2->second.begin(); it3!=it2->second.end(); ++it3)
+        {
+            value.append(util.UcAsByteSeq(it3->first));
+            value.append(util.UlAsByteSeq(it3->second));
+        }
+    }
+    key="CD"; // entries to download
+    scheduledActions->Put(rocksdb::WriteOptions(), key, value);
+
+    for (unsigned char listType=0; listType<5; listType++)
+    {
+        UpToDateTimeInfo* info = getInfoFromType(listType);
+        value="";
+        map<unsigned long, CompleteID>::iterator it4;
+        for (it4=info->individualUpToDates.begin(); it4!=info->individualUpToDates.end(); ++it4)
+        {
+            value.append(util.UlAsByteSeq(it4->first));
+            value.append(it4->second.to20Char());
+        }
+        key="CU"; // individual up-to-date ids
+        key.append(util.UcAsByteSeq(listType));
+        scheduledActions->Put(rocksdb::WriteOptions(), key, value);
+    }
+}
+
+// db must be locked for this
+// only restores what is still valid: up-to-date ids of followed notaries beyond the overall one,
+// entries to sign which are still the last in their block and entries to download which are still missing
+void Database::loadCheckpoint()
+{
+    string key("CT"); // time of checkpoint
+    string value;
+    rocksdb::Status s = scheduledActions->Get(rocksdb::ReadOptions(), key, &value);
+    if (!s.ok() || value.length()!=8) return;
+    const unsigned long long checkpointTime = util.byteSeqAsUll(value);
+    const unsigned long long currentTime = systemTimeInMs();
+    if (checkpointTime > currentTime) return;
+    string dum;
+
+    // individual up-to-date ids
+    size_t restoredUpToDates = 0;
+    for (unsigned char listType=0; listType<5; listType++)
+    {
+        UpToDateTimeInfo* info = getInfoFromType(listType);
+        key="CU"; // individual up-to-date ids
+        key.append(util.UcAsByteSeq(listType));
+        s = scheduledActions->Get(rocksdb::ReadOptions(), key, &value);
+        if (!s.ok() || value.length() % 24 != 0) continue;
+        for (size_t pos=0; pos<value.length(); pos+=24)
+        {
+            dum = value.substr(pos, 4);
+            unsigned long notary = util.byteSeqAsUl(dum);
+            dum = value.substr(pos+4, 20);
+            CompleteID id(dum);
+            if (info->individualUpToDates.count(notary)<=0) continue;
+            if (id <= info->individualUpToDates[notary] || id.getTimeStamp() > currentTime) continue;
+            updateIndividualUpToDate(info, notary, id);
+            restoredUpToDates++;
+        }
+        if (correctUpToDateTime(info)) saveUpToDateTime(listType);
+    }
+
+    // entries to sign and to download
+    size_t restoredToSign = 0;
+    size_t restoredToDownload = 0;
+    if (checkpointTime + maxCheckpointAgeInMs >= currentTime)
+    {
+        key="CS"; // entries to sign
+        s = scheduledActions->Get(rocksdb::ReadOptions(), key, &value);
+        if (s.ok() && value.length() % 28 == 0)
+        {
+            for (size_t pos=0; pos<value.length(); pos+=28)
+            {
+                dum = value.substr(pos, 8);
+                unsigned long long time = util.byteSeqAsUll(dum);
+                dum = value.substr(pos+8, 20);
+                CompleteID id(dum);
+                if (type1entry->getLineage(time) != type1entry->latestLin() || !isLastInBlock(id)) continue;
+                entriesToSign.insert(pair<unsigned long long,CompleteID>(time, id));
+                if (time < nextSigningTime) nextSigningTime = time;
+                restoredToSign++;
+            }
+        }
+
+        key="CD"; // entries to download
+        s = scheduledActions->Get(rocksdb::ReadOptions(), key, &value);
+        size_t pos = 0;
+        while (s.ok() && pos+24 <= value.length())
+        {
+            dum = value.substr(pos, 20);
+            CompleteID id(dum);
+            dum = value.substr(pos+20, 4);
+            unsigned long neededForCount = util.byteSeqAsUl(dum);
+            pos+=24;
+            if (pos + neededForCount * 5 > value.length()) break;
+            const bool missing = !isInGeneralList(id);
+            if (missing && neededForCount == 0) downloads.add(id, 0, 0);
+            for (unsigned long i=0; i<neededForCount; i++)
+            {
+                dum = value.substr(pos, 1);
+                unsigned char listType = util.byteSeqAsUc(dum);
+                dum = value.substr(pos+1, 4);
+                unsigned long notary = util.byteSeqAsUl(dum);
+                pos+=5;
+                if (missing) downloads.add(id, listType, notary);
+            }
+            if (missing) restoredToDownload++;
+        }
+    }
+
+    string msg("restored from checkpoint: ");
+    msg.append(to_string(restoredUpToDates));
+    msg.append(" up-to-date ids, ");
+    msg.append(to_string(restoredToSign));
+    msg.append(" entries to sign, ");
+    msg.append(to_string(restoredToDownload));
+    msg.append(" entries to download");
+    puts(msg.c_str());
+}
+
 // db must be locked for this
 bool Database::dbUpToDate(unsigned long long wellConnectedSince)
 {
@@ -376,6 +900,19 @@ bool Database::dbUpToDate(unsigned long long wellConnectedSince)
     return true;
 }
 
+// db must be locked for this
+void Database::publishNodeStatus(unsigned long long wellConnectedSince)
+{
+    const bool upToDate = dbUpToDate(wellConnectedSince);
+    nodeStatus.publish(amCurrentlyActingWithBuffer(), upToDate, systemTimeInMs());
+}
+
+// can be called without locking the db
+bool Database::amActingAndUpToDate()
+{
+    return nodeStatus.isActingAndUpToDate();
+}
+
 // db must be locked for this
 CompleteID Database::getUpToDateID(unsigned char listType)
 {
@@ -427,6 +964,8 @@ CompleteID Database::getUpToDateID(unsigned char listType)
 
 Database::~Database()
 {
+    persistExchangeOfferRatios();
+    syncWAL();
     delete type1entry;
     delete notaries;
     delete entriesInNotarization;
@@ -440,25 +979,8 @@ Database::~Database()
     delete conflicts;
     delete perpetualEntries;
     delete transfersWithFees;
-
-    // destroy entriesToDownload, entriesInDownload
-    map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>::iterator it;
-    for (it = ((map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>*)entriesToDownload)->begin();
-            it != ((map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>*)entriesToDownload)->end(); ++it)
-    {
-        DownloadStatus* status = it->second;
-        delete status;
-    }
-    ((map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>*)entriesToDownload)->clear();
-    delete entriesToDownload;
-    for (it = ((map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>*)entriesInDownload)->begin();
-            it != ((map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>*)entriesInDownload)->end(); ++it)
-    {
-        DownloadStatus* status = it->second;
-        delete status;
-    }
-    ((map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>*)entriesInDownload)->clear();
-    delete entriesInDownload;
+    delete listsDB;
+    pthread_rwlock_destroy(&db_rwlock);
 
     // destroy UpToDateTimeInfo
     delete listEssentials;
@@ -478,33 +1000,32 @@ bool Database::loadNewerEntriesIds(unsigned char listType, CompleteID &benchmark
 
     string keyPref;
     rocksdb::Iterator* it;
-    string keyStr;
 
     if (listType==0)
     {
         keyPref.push_back('B'); // prefix for body
-        it = essentialEntries->NewIterator(rocksdb::ReadOptions());
+        it = essentialEntries->NewPrefixIterator(keyPref);
     }
     else if (listType==1)
     {
         keyPref.push_back('B'); // prefix for body
-        it = notarizationEntries->NewIterator(rocksdb::ReadOptions());
+        it = notarizationEntries->NewPrefixIterator(keyPref);
     }
     else if (listType==2)
     {
         keyPref.push_back('B'); // prefix for body
         keyPref.append(util.UcAsByteSeq(5));
-        it = notaryApplications->NewIterator(rocksdb::ReadOptions());
+        it = notaryApplications->NewPrefixIterator(keyPref);
     }
     else if (listType==3)
     {
         keyPref.push_back('B'); // prefix for body
-        it = perpetualEntries->NewIterator(rocksdb::ReadOptions());
+        it = perpetualEntries->NewPrefixIterator(keyPref);
     }
     else if (listType==4)
     {
         keyPref.push_back('B'); // prefix for body
-        it = transfersWithFees->NewIterator(rocksdb::ReadOptions());
+        it = transfersWithFees->NewPrefixIterator(keyPref);
     }
     else return false;
 
@@ -516,19 +1037,22 @@ bool Database::loadNewerEntriesIds(unsigned char listType, CompleteID &benchmark
     CompleteID upperLimit(0, 0, currentTime-upToDateBuffer);
 
     // search forward
-    unsigned long prefLength = keyPref.length();
-    string keyMin;
-    keyMin.append(keyPref);
-    keyMin.append(benchmarkId.to20Char());
-    for (it->Seek(keyMin); it->Valid() && newerIDs.size()<2; it->Next())
+    const rocksdb::Slice pref(keyPref);
+    DBKey keyMin;
+    keyMin.add(keyPref).add(benchmarkId);
+    if (!keyMin.isGood())
+    {
+        delete it;
+        return false;
+    }
+    for (it->Seek(keyMin.slice()); it->Valid() && newerIDs.size()<2; it->Next())
     {
         // check the prefix
-        keyStr = it->key().ToString();
-        if (keyStr.length() < prefLength+20) break;
-        if (keyStr.substr(0, prefLength).compare(keyPref) != 0) break;
+        rocksdb::Slice keySlice = it->key();
+        if (keySlice.size() < pref.size()+20) break;
+        if (!keySlice.starts_with(pref)) break;
         // extract id
-        string idStr = keyStr.substr(prefLength, 20);
-        CompleteID id = CompleteID(idStr);
+        CompleteID id = DBKey::idAt(keySlice, pref.size());
         // check whether upper limit is reached
         if (id >= upperLimit) break;
         // add if new
@@ -625,133 +1149,55 @@ void Database::saveUpToDateTime(unsigned char listType)
 // for this the db object must be locked first
 CompleteID Database::getOldestEntryToDownload()
 {
-    map<CompleteID, DownloadStatus*, CompleteID::CompareIDs> *entriesInD =
-        (map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>*)entriesInDownload;
-    map<CompleteID, DownloadStatus*, CompleteID::CompareIDs> *entriesToD =
-        (map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>*)entriesToDownload;
-    if (entriesInD->empty() && entriesToD->empty()) return CompleteID(0,0,0);
-    else if (entriesInD->empty()) return entriesToD->begin()->first;
-    else if (entriesToD->empty()) return entriesInD->begin()->first;
-    CompleteID id1 = entriesToD->begin()->first;
-    CompleteID id2 = entriesInD->begin()->first;
-    if (id1<id2) return id1;
-    return id2;
+    return downloads.getOldest();
 }
 
 // for this the db object must be locked first
 size_t Database::getEntriesInDownload()
 {
-    map<CompleteID, DownloadStatus*, CompleteID::CompareIDs> *entriesInD =
-        (map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>*)entriesInDownload;
-    map<CompleteID, DownloadStatus*, CompleteID::CompareIDs> *entriesToD =
-        (map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>*)entriesToDownload;
-    return entriesToD->size() + entriesInD->size();
+    return downloads.size();
+}
+
+// for this the db object must be locked first
+unsigned long long Database::getNextDownloadRetryTime()
+{
+    return downloads.getNextRetryTime();
 }
 
 // for this the db object must be locked first
+// only entries without missing predecessors are looked at, each at most every minTimeBetweenDownloadAttemptsInMs
 CompleteID Database::getNextEntryToDownload()
 {
-    map<CompleteID, DownloadStatus*, CompleteID::CompareIDs> *entriesInD =
-        (map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>*)entriesInDownload;
-    map<CompleteID, DownloadStatus*, CompleteID::CompareIDs> *entriesToD =
-        (map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>*)entriesToDownload;
     unsigned long long currentTime = systemTimeInMs();
     CompleteID zeroID;
-    while (!entriesToD->empty())
+    CompleteID id;
+    while (downloads.takeNextReady(currentTime, id))
     {
-        CompleteID id = entriesToD->begin()->first;
-        DownloadStatus *status = entriesToD->begin()->second;
-        entriesToD->erase(id);
-
         if ((isInGeneralList(id) && getConnectedTransfer(id,zeroID)!=id)
-                || status->attempts >= maxDownloadAttempts)
+                || downloads.getAttempts(id) >= maxDownloadAttempts)
         {
-            delete status;
-            if (missingPredecessors.count(id)>0)
-            {
-                delete missingPredecessors[id];
-                missingPredecessors.erase(id);
-            }
-            if (missingNotaries.count(id)>0)
-            {
-                delete missingNotaries[id];
-                missingNotaries.erase(id);
-            }
-            if (lastDownloadAttempt.count(id)>0)
-            {
-                lastDownloadAttempt.erase(id);
-            }
+            downloads.remove(id, nullptr);
+            continue;
         }
-        else
+        // check if any notaries still missing
+        set<unsigned long>* listMissing = downloads.getMissingNotaries(id);
+        while (listMissing->size() > 0)
         {
-            entriesInD->insert(pair<CompleteID, DownloadStatus*>(id,status));
-            // check if any predecessors still missing
-            bool predecessorsMissing = true;
-            if (missingPredecessors.count(id) > 0)
-            {
-                CIDsSet* listMissing = missingPredecessors[id];
-                while (!listMissing->isEmpty())
-                {
-                    CompleteID firstMissing = listMissing->first();
-                    if (isInGeneralList(firstMissing)
-                            || (entriesToD->count(firstMissing) <= 0
-                                && entriesInD->count(firstMissing) <= 0))
-                    {
-                        listMissing->deleteFirst();
-                    }
-                    else break;
-                }
-                if (listMissing->isEmpty())
-                {
-                    delete listMissing;
-                    missingPredecessors.erase(id);
-                    predecessorsMissing = false;
-                }
-            }
-            else predecessorsMissing = false;
-            // check if any notaries still missing
-            bool notariesMissing = true;
-            if (missingNotaries.count(id) > 0)
-            {
-                set<unsigned long>* listMissing = missingNotaries[id];
-                while (listMissing->size() > 0)
-                {
-                    unsigned long firstMissing = *listMissing->begin();
-                    if (isActingNotary(firstMissing, id.getTimeStamp()))
-                    {
-                        listMissing->erase(listMissing->begin());
-                    }
-                    else break;
-                }
-                if (listMissing->size() <= 0)
-                {
-                    delete listMissing;
-                    missingNotaries.erase(id);
-                    notariesMissing = false;
-                }
-            }
-            else notariesMissing = false;
-            // attempt download
-            if (!predecessorsMissing &&
-                    (lastDownloadAttempt.count(id) <= 0
-                     || currentTime >= lastDownloadAttempt[id] + minTimeBetweenDownloadAttemptsInMs))
+            unsigned long firstMissing = *listMissing->begin();
+            if (isActingNotary(firstMissing, id.getTimeStamp()))
             {
-                if (lastDownloadAttempt.count(id) <= 0)
-                {
-                    lastDownloadAttempt.insert(pair<CompleteID, unsigned long long>(id,currentTime));
-                }
-                else lastDownloadAttempt[id] = currentTime;
-                status->attempts++;
-                if (!notariesMissing)
-                {
-                    return id;
-                }
+                listMissing->erase(listMissing->begin());
             }
+            else break;
+        }
+        const bool notariesMissing = (listMissing->size() > 0);
+        // attempt download
+        downloads.attempted(id, currentTime);
+        if (!notariesMissing)
+        {
+            return id;
         }
     }
-    volatile map<CompleteID, DownloadStatus*, CompleteID::CompareIDs> *tmp=entriesInDownload;
-    entriesInDownload=entriesToDownload;
-    entriesToDownload=tmp;
     return CompleteID(0,0,0);
 }
 
@@ -765,9 +1211,10 @@ unsigned long long Database::systemTimeInMs()
 }
 
 // db must be locked for this
+// participationRank 0 marks the leading participant, which signs immediately;
+// all others only sign if the chain has not moved on after their time buffer
 bool Database::addToEntriesToSign(CompleteID &signatureId, unsigned short participationRank)
 {
-    if (participationRank<=0) return false;
     unsigned int lineage = type1entry->getLineage(signatureId.getTimeStamp());
     if (lineage != type1entry->latestLin()) return false;
     if (ownNumber <= 0) return false;
@@ -779,9 +1226,17 @@ bool Database::addToEntriesToSign(CompleteID &signatureId, unsigned short partic
     {
         entriesToSign.insert(LLC);
     }
+    if (time < nextSigningTime) nextSigningTime = time;
+    if (scheduler != nullptr) scheduler->scheduleAt(taskSignEntries, time);
     return true;
 }
 
+// can be called without locking the db
+unsigned long long Database::getNextSigningTime()
+{
+    return nextSigningTime;
+}
+
 // db must be locked for this
 bool Database::isLastInBlock(CompleteID &signatureID)
 {
@@ -799,7 +1254,7 @@ bool Database::isLastInBlock(CompleteID &signatureID)
     }
     // try to find successor in block
     string key;
-    rocksdb::DB* dbList = entriesInNotarization;
+    DBList* dbList = entriesInNotarization;
     if (renot)
     {
         key.push_back('I'); // prefix for in renotarization
@@ -828,12 +1283,15 @@ bool Database::loadNextEntryToSign(string &type13entryStr, string &type12entrySt
     while (id.isZero() && !entriesToSign.empty())
     {
         pair<unsigned long long,CompleteID> item = *entriesToSign.begin();
-        if (item.first > systemTimeInMs()) return false;
+        if (item.first > systemTimeInMs()) break;
         id = item.second;
         entriesToSign.erase(item);
         if (type1entry->getLineage(item.first) != type1entry->latestLin()) id=CompleteID();
         else if (!isLastInBlock(id)) id=CompleteID();
     }
+    // update time of next signature
+    if (entriesToSign.empty()) nextSigningTime = ULLONG_MAX;
+    else nextSigningTime = entriesToSign.begin()->first;
     if (id.isZero()) return false;
     // load strings
     unsigned char l = 1;
@@ -846,14 +1304,14 @@ bool Database::loadNextEntryToSign(string &type13entryStr, string &type12entrySt
     return true;
 }
 
-// db must be locked for this
+// can be called without locking the db
 bool Database::amCurrentlyActing()
 {
     if (ownNumber<=0) return false;
     return isActingNotary(ownNumber, systemTimeInMs());
 }
 
-// db must be locked for this
+// can be called without locking the db
 bool Database::amCurrentlyActingWithBuffer()
 {
     if (ownNumber<=0) return false;
@@ -864,7 +1322,7 @@ bool Database::amCurrentlyActingWithBuffer()
     return isActingNotaryWithBuffer(tNtrNr, currentTime);
 }
 
-// db must be locked for this
+// can be called without locking the db
 bool Database::isActingNotaryWithBuffer(TNtrNr tNtrNr, unsigned long long currentTime)
 {
     bool isActing = isActingNotary(tNtrNr, currentTime);
@@ -878,7 +1336,7 @@ bool Database::isActingNotaryWithBuffer(TNtrNr tNtrNr, unsigned long long curren
     return isActing;
 }
 
-// db must be locked for this
+// can be called without locking the db
 bool Database::isActingNotary(TNtrNr tNtrNr, unsigned long long currentTime)
 {
     if (type1entry->getLineage(currentTime) != tNtrNr.getLineage()) return false;
@@ -886,7 +1344,7 @@ bool Database::isActingNotary(TNtrNr tNtrNr, unsigned long long currentTime)
     return true;
 }
 
-// db must be locked for this
+// can be called without locking the db
 bool Database::isActingNotary(unsigned long notaryNr, unsigned long long currentTime)
 {
     if (!type1entry->isActingNotary(notaryNr, currentTime)) return false;
@@ -924,7 +1382,7 @@ set<unsigned long>* Database::getFutureActingNotaries(unsigned long long futureT
     return notariesList;
 }
 
-// db must be locked for this
+// can be called without locking the db
 set<unsigned long>* Database::getActingNotaries(unsigned long long currentTime)
 {
     // calculate theoretical numbers (interval)
@@ -949,7 +1407,7 @@ set<unsigned long>* Database::getActingNotaries(unsigned long long currentTime)
 
     // create actual list
     set<unsigned long>* notariesList = new set<unsigned long>();
-    unsigned long notariesCount = getNrOfNotariesInLineage(lineageNr);
+    unsigned long notariesCount = notaryTimeline.getNotariesCount(lineageNr);
     if (notariesCount < earliestActingNr) return notariesList;
     if (notariesCount < latestActingNr) latestActingNr = notariesCount;
     for (unsigned long i=earliestActingNr; i<=latestActingNr; i++)
@@ -1305,49 +1763,38 @@ void Database::verifySchedules(CompleteID &entryID)
     }
 }
 
+// db must be locked for this
+void Database::storeExpectedTermination(CompleteID &threadId, unsigned long long terminationTime)
+{
+    string key("E"); // prefix for expected terminations
+    key.append(util.flip(util.UllAsByteSeq(terminationTime)));
+    key.append(threadId.to20Char());
+    scheduledActions->Put(rocksdb::WriteOptions(), key, threadId.to20Char());
+    expectedTerminations.schedule(threadId, terminationTime);
+    if (scheduler != nullptr) scheduler->scheduleAt(taskCheckThreadTerminations, terminationTime);
+}
+
 // db must be locked for this
 void Database::checkThreadTerminations()
 {
-    string keyPref;
-    keyPref.push_back('E'); // prefix for expected terminations
-    size_t prefLength=keyPref.length();
-    rocksdb::Iterator* it = scheduledActions->NewIterator(rocksdb::ReadOptions());
-    list<string> toDeleteList;
     unsigned long long currentTime = systemTimeInMs();
-    for (it->Seek(keyPref); it->Valid(); it->Next())
-    {
-        // check the prefix
-        string keyStr = it->key().ToString();
-        if (keyStr.substr(0, prefLength).compare(keyPref) != 0)
-        {
-            break;
-        }
-        if (keyStr.length()!=prefLength+28)
-        {
-            toDeleteList.push_back(keyStr);
-            continue;
-        }
-        // get termination time and threadId
-        string timeStr = util.flip(keyStr.substr(prefLength, 8));
-        string idStr =  keyStr.substr(prefLength+8, 20);
-        unsigned long long terminationTime = util.byteSeqAsUll(timeStr);
-        CompleteID threadId(idStr);
-        if (terminationTime>currentTime) break;
-        else
-        {
-            CompleteID zeroId;
-            if (!hasThreadSuccessor(threadId, zeroId)) storeT9eCreationParameters(threadId, terminationTime);
-            toDeleteList.push_back(keyStr);
-        }
-    }
-    delete it;
-    // clean up
-    list<string>::iterator it2;
-    for (it2=toDeleteList.begin(); it2!=toDeleteList.end(); ++it2)
+    CompleteID threadId;
+    unsigned long long terminationTime;
+    while (expectedTerminations.takeDue(currentTime, threadId, terminationTime))
     {
-        scheduledActions->Delete(rocksdb::WriteOptions(), *it2);
+        CompleteID zeroId;
+        if (!hasThreadSuccessor(threadId, zeroId)) storeT9eCreationParameters(threadId, terminationTime);
+        string key("E"); // prefix for expected terminations
+        key.append(util.flip(util.UllAsByteSeq(terminationTime)));
+        key.append(threadId.to20Char());
+        scheduledActions->Delete(rocksdb::WriteOptions(), key);
     }
-    return;
+}
+
+// db must be locked for this
+unsigned long long Database::getNextTerminationTime()
+{
+    return expectedTerminations.getEarliest();
 }
 
 // db must be locked for this
@@ -1356,7 +1803,7 @@ bool Database::loadNextTerminatingThread(CompleteID &lastEntryId)
     string keyPref;
     keyPref.push_back('A'); // prefix for termination attempts
     size_t prefLength=keyPref.length();
-    rocksdb::Iterator* it = scheduledActions->NewIterator(rocksdb::ReadOptions());
+    rocksdb::Iterator* it = scheduledActions->NewPrefixIterator(keyPref);
     list<string> toDeleteList;
     list<string> toReparametrizeList;
     CompleteID outId;
@@ -1435,6 +1882,21 @@ bool Database::loadNextTerminatingThread(CompleteID &lastEntryId)
     return true;
 }
 
+// db must be locked for this
+// claims up to maxThreads terminations which are due (with one write), returns their number
+size_t Database::loadNextTerminatingThreads(size_t maxThreads, list<CompleteID> &lastEntryIds)
+{
+    WriteBatchScope batchScope(this);
+    size_t claimed = 0;
+    CompleteID lastEntryId;
+    while (claimed < maxThreads && loadNextTerminatingThread(lastEntryId))
+    {
+        lastEntryIds.push_back(lastEntryId);
+        claimed++;
+    }
+    return claimed;
+}
+
 // db must be locked for this
 bool Database::eligibleForRenotarization(CompleteID &entryId)
 {
@@ -1523,57 +1985,39 @@ bool Database::eligibleForRenotarization(CompleteID &entryId)
 // db must be locked for this
 void Database::updateRenotarizationAttempts()
 {
-    // set prefix
-    string keyPref("P");
-    size_t prefLength=keyPref.length();
-    // build minKey
-    string maxKey(keyPref);
-    unsigned short lineage = type1entry->latestLin();
-    unsigned long long maxTime = type1entry->getFreshnessTime(lineage);
-    maxTime *= 650;
-    maxTime = systemTimeInMs() - maxTime;
-    CompleteID maxId(0, 0, maxTime);
-    maxKey.append(maxId.to20Char());
-    // iterate
-    rocksdb::Iterator* it = subjectToRenotarization->NewIterator(rocksdb::ReadOptions());
-    list<string> toDeleteList;
-    list<string> toReparametrizeList;
-    string oldIdStr("");
-    for (it->SeekForPrev(maxKey); it->Valid(); it->Prev())
+    // only entries due for a review (entries with own attempts are checked when attempted)
+    list<CompleteID> dueList;
+    CompleteID entryId;
+    unsigned long long reviewTime;
+    unsigned long long currentTime = systemTimeInMs();
+    while (renotarizationSubjects.takeDue(currentTime, entryId, reviewTime))
+    {
+        dueList.push_back(entryId);
+    }
+    list<CompleteID> toDeleteList;
+    list<CompleteID> toReparametrizeList;
+    list<CompleteID>::iterator it;
+    for (it=dueList.begin(); it!=dueList.end(); ++it)
     {
-        // check the prefix
-        string keyStr = it->key().ToString();
-        if (keyStr.length() <= prefLength) break;
-        if (keyStr.substr(0, prefLength).compare(keyPref) != 0) break;
-        // get id
-        string idStr = keyStr.substr(prefLength, 20);
-        if (idStr.compare(oldIdStr) == 0) continue;
-        oldIdStr = idStr;
-        CompleteID id(idStr);
-        if (id >= maxId) continue;
         // check eligibility
-        if (!eligibleForRenotarization(id))
+        if (!eligibleForRenotarization(*it))
         {
-            toDeleteList.push_back(idStr);
+            toDeleteList.push_back(*it);
         }
         else
         {
-            toReparametrizeList.push_back(idStr);
+            toReparametrizeList.push_back(*it);
         }
     }
-    delete it;
     // clean up
-    list<string>::iterator it2;
-    for (it2=toDeleteList.begin(); it2!=toDeleteList.end(); ++it2)
+    for (it=toDeleteList.begin(); it!=toDeleteList.end(); ++it)
     {
-        CompleteID id(*it2);
-        deleteRenotarizationParameters(id);
+        deleteRenotarizationParameters(*it);
     }
-    for (it2=toReparametrizeList.begin(); it2!=toReparametrizeList.end(); ++it2)
+    for (it=toReparametrizeList.begin(); it!=toReparametrizeList.end(); ++it)
     {
-        CompleteID id(*it2);
-        deleteRenotarizationParameters(id);
-        storeRenotarizationParameters(id);
+        deleteRenotarizationParameters(*it);
+        storeRenotarizationParameters(*it);
     }
     // report
     if (toDeleteList.size()>0) puts("Database::updateRenotarizationAttempts: toDeleteList not empty");
@@ -1616,7 +2060,9 @@ bool Database::storeRenotarizationParameters(CompleteID &entryId)
             key.append(util.flip(util.UllAsByteSeq(earliestTime)));
             key.append(entryId.to20Char());
             subjectToRenotarization->Put(rocksdb::WriteOptions(), key, entryId.to20Char());
+            renotarizationAttempts.schedule(entryId, earliestTime);
         }
+        else renotarizationSubjects.schedule(entryId, getNextRenotarizationReview(entryId, 1));
         return true;
     }
     // get earliest renotarization start time
@@ -1666,7 +2112,9 @@ bool Database::storeRenotarizationParameters(CompleteID &entryId)
         key.append(util.flip(util.UllAsByteSeq(ownTime)));
         key.append(entryId.to20Char());
         subjectToRenotarization->Put(rocksdb::WriteOptions(), key, entryId.to20Char());
+        renotarizationAttempts.schedule(entryId, ownTime);
     }
+    else renotarizationSubjects.schedule(entryId, getNextRenotarizationReview(entryId, actingNotaries->size()));
     delete actingNotaries;
     return true;
 }
@@ -1697,10 +2145,34 @@ void Database::deleteRenotarizationParameters(CompleteID &entryId)
         key.append(util.UlAsByteSeq(c));
         toDeleteList.push_back(key);
     }
+    // own attempt
+    unsigned long long attemptTime;
+    if (renotarizationAttempts.getDeadline(entryId, attemptTime))
+    {
+        key="A"; // prefix for attempt
+        key.append(util.flip(util.UllAsByteSeq(attemptTime)));
+        key.append(entryId.to20Char());
+        toDeleteList.push_back(key);
+    }
     // clean up
     list<string>::iterator it;
     for (it=toDeleteList.begin(); it!=toDeleteList.end(); ++it)
         subjectToRenotarization->Delete(rocksdb::WriteOptions(), *it);
+    renotarizationSubjects.remove(entryId);
+    renotarizationAttempts.remove(entryId);
+}
+
+// db must be locked for this
+// entries without own attempt are reviewed once older than 65% of the freshness time, then after each round of attempts
+unsigned long long Database::getNextRenotarizationReview(CompleteID &entryId, unsigned long listLength)
+{
+    unsigned long long reviewTime = type1entry->getFreshnessTime(type1entry->latestLin());
+    reviewTime *= 650;
+    reviewTime += entryId.getTimeStamp();
+    unsigned long long currentTime = systemTimeInMs();
+    if (reviewTime > currentTime) return reviewTime;
+    unsigned long long step = type1entry->getLatestMaxNotarizationTime() * max(listLength, (unsigned long) 1);
+    return currentTime + step;
 }
 
 // db must be locked for this
@@ -1720,68 +2192,45 @@ unsigned long long Database::getEarliestRenotTime(CompleteID &entryId)
 // db must be locked for this
 int Database::loadNextEntryToRenotarize(CompleteID &entryId)
 {
-    string keyPref("A");
-    size_t prefLength=keyPref.length();
-    rocksdb::Iterator* it = subjectToRenotarization->NewIterator(rocksdb::ReadOptions());
-    list<string> toDeleteList;
-    list<string> toReparametrizeList;
+    // only own attempts which are due
+    list<CompleteID> toDeleteList;
+    list<CompleteID> toReparametrizeList;
     CompleteID outId;
+    CompleteID id;
     unsigned long long attemptTime=0;
     unsigned long long currentTime = systemTimeInMs();
-    for (it->Seek(keyPref); it->Valid(); it->Next())
+    while (renotarizationAttempts.takeDue(currentTime, id, attemptTime))
     {
-        // check the prefix
-        string keyStr = it->key().ToString();
-        if (keyStr.substr(0, prefLength).compare(keyPref) != 0)
-        {
-            break;
-        }
-        if (keyStr.length()!=prefLength+28)
-        {
-            toDeleteList.push_back(keyStr);
-            continue;
-        }
-        // get latest time and entryId
-        string timeStr = util.flip(keyStr.substr(prefLength, 8));
-        attemptTime = util.byteSeqAsUll(timeStr);
-        string idStr = keyStr.substr(prefLength+8, 20);
-        CompleteID id(idStr);
+        string keyStr("A"); // prefix for attempt
+        keyStr.append(util.flip(util.UllAsByteSeq(attemptTime)));
+        keyStr.append(id.to20Char());
+        subjectToRenotarization->Delete(rocksdb::WriteOptions(), keyStr);
         // check eligibility
         if (!eligibleForRenotarization(id))
         {
-            toDeleteList.push_back(keyStr);
+            toDeleteList.push_back(id);
             continue;
         }
         // check lineage
         if (getScheduledLineage(id, true) != type1entry->latestLin())
         {
-            toReparametrizeList.push_back(keyStr);
+            toReparametrizeList.push_back(id);
             continue;
         }
-        // check if not too early
-        if (currentTime<attemptTime) break;
         // break and report
         outId = id;
-        subjectToRenotarization->Delete(rocksdb::WriteOptions(), keyStr);
         break;
     }
-    delete it;
     // clean up
-    list<string>::iterator it2;
-    for (it2=toDeleteList.begin(); it2!=toDeleteList.end(); ++it2)
+    list<CompleteID>::iterator it;
+    for (it=toDeleteList.begin(); it!=toDeleteList.end(); ++it)
     {
-        subjectToRenotarization->Delete(rocksdb::WriteOptions(), *it2);
-        string idStr = (*it2).substr(prefLength+8, 20);
-        CompleteID id(idStr);
-        deleteRenotarizationParameters(id);
+        deleteRenotarizationParameters(*it);
     }
-    for (it2=toReparametrizeList.begin(); it2!=toReparametrizeList.end(); ++it2)
+    for (it=toReparametrizeList.begin(); it!=toReparametrizeList.end(); ++it)
     {
-        subjectToRenotarization->Delete(rocksdb::WriteOptions(), *it2);
-        string idStr = (*it2).substr(prefLength+8, 20);
-        CompleteID id(idStr);
-        deleteRenotarizationParameters(id);
-        storeRenotarizationParameters(id);
+        deleteRenotarizationParameters(*it);
+        storeRenotarizationParameters(*it);
     }
     // if nothing found
     if (outId.getNotary()<=0) return -1;
@@ -1798,38 +2247,73 @@ int Database::loadNextEntryToRenotarize(CompleteID &entryId)
     key.append(util.flip(util.UllAsByteSeq(ownTime)));
     key.append(entryId.to20Char());
     subjectToRenotarization->Put(rocksdb::WriteOptions(), key, entryId.to20Char());
+    renotarizationAttempts.schedule(entryId, ownTime);
     // return
     if (currentTime > attemptTime + type1entry->getLatestMaxNotarizationTime()) return 0;
     return 1;
 }
 
 // db must be locked for this
+// claims up to maxEntries renotarization attempts which are due (with one write), returns the number of attempts
+// jobs only get the entries which can be signed
+size_t Database::loadNextEntriesToRenotarize(size_t maxEntries, list<RenotarizationJob> &jobs)
+{
+    WriteBatchScope batchScope(this);
+    size_t claimed = 0;
+    CompleteID entryId;
+    while (claimed < maxEntries)
+    {
+        int attemptStatus = loadNextEntryToRenotarize(entryId);
+        if (attemptStatus == -1) break;
+        claimed++;
+        if (attemptStatus == 0) continue;
+
+        RenotarizationJob job;
+        job.entryId = entryId;
+        if (!loadType13EntryStr(entryId, 0, job.t13eStr)) continue;
+        CompleteID entryIdFirst = getFirstID(entryId);
+        string t13eFirstStr;
+        if (!loadType13EntryStr(entryIdFirst, 0, t13eFirstStr)) continue;
+        job.t12e = createT12FromT13Str(t13eFirstStr);
+        if (job.t12e == nullptr) continue;
+        jobs.push_back(job);
+    }
+    return claimed;
+}
+
+// db must be locked for this (shared lock is sufficient)
 CompleteID Database::getFirstID(CompleteID &id)
 {
-    string key;
+    CompleteID firstNotID;
+    if (firstIdCache.get(id, firstNotID)) return firstNotID;
+    DBKey key('B', id, "FN"); // suffix for id of first notarization entry
     string value;
-    key.push_back('B'); // prefix to distinguish from list head
-    key.append(id.to20Char());
-    key.append("FN"); // suffix for id of first notarization entry
-    rocksdb::Status s = notarizationEntries->Get(rocksdb::ReadOptions(), key, &value);
+    KeyFilter* filter = notarizationEntries->getFilter();
+    if (filter != nullptr && !filter->mayContain(key.slice())) return CompleteID();
+    rocksdb::Status s = notarizationEntries->Get(rocksdb::ReadOptions(), key.slice(), &value);
     const bool success = (s.ok() && value.length()>2);
-    if (!success) return CompleteID();
-    CompleteID firstNotID(value);
+    if (!success)
+    {
+        if (filter != nullptr) filter->falsePositive();
+        return CompleteID();
+    }
+    firstNotID = CompleteID(value);
+    firstIdCache.put(id, firstNotID);
     return firstNotID;
 }
 
-// db must be locked for this
+// db must be locked for this (shared lock is sufficient)
 CompleteID Database::getLatestID(CompleteID &firstID)
 {
-    string key;
+    CompleteID latestNotId;
+    if (latestIdCache.get(firstID, latestNotId)) return latestNotId;
+    DBKey key('B', firstID, "LN"); // suffix for id of latest known notarization entry
     string value;
-    key.push_back('B'); // prefix to distinguish from list head
-    key.append(firstID.to20Char());
-    key.append("LN"); // suffix for id of latest known notarization entry
-    rocksdb::Status s = notarizationEntries->Get(rocksdb::ReadOptions(), key, &value);
+    rocksdb::Status s = notarizationEntries->Get(rocksdb::ReadOptions(), key.slice(), &value);
     const bool success = (s.ok() && value.length()>2);
     if (!success) return CompleteID();
-    CompleteID latestNotId(value);
+    latestNotId = CompleteID(value);
+    latestIdCache.put(firstID, latestNotId);
     return latestNotId;
 }
 
@@ -1841,9 +2325,15 @@ CompleteID Database::getFirstID(string* pubKey)
     key.push_back('B'); // suffix for key identification by byte sequence
     key.append(util.UlAsByteSeq(pubKey->length()));
     key.append(*pubKey);
+    KeyFilter* filter = publicKeys->getFilter();
+    if (filter != nullptr && !filter->mayContain(key)) return CompleteID();
     rocksdb::Status s = publicKeys->Get(rocksdb::ReadOptions(), key, &value);
     const bool success = (s.ok() && value.length()>2);
-    if (!success) return CompleteID();
+    if (!success)
+    {
+        if (filter != nullptr) filter->falsePositive();
+        return CompleteID();
+    }
     CompleteID id(value);
     return id;
 }
@@ -1853,6 +2343,14 @@ bool Database::loadInitialT13EntryStr(CompleteID &idFirst, string &str)
 {
     // obtain the underlying entry from the general list of
     // notarization entries using this complete id
+    string packed;
+    if (loadPackedSignatures(idFirst, packed))
+    {
+        vector<rocksdb::Slice> entries;
+        if (!unpackSignatures(packed, entries) || entries.empty()) return false;
+        str = entries.front().ToString();
+        return (str.length()>2);
+    }
     string key;
     key.push_back('B'); // prefix to distinguish from list head
     key.append(idFirst.to20Char());
@@ -2072,6 +2570,22 @@ Type12Entry* Database::createT12FromT13Str(string &str)
     return type12entry;
 }
 
+// checks the layout of an initial type 13 entry (as in createT12FromT13Str) without parsing it
+bool Database::isInitialT13Str(const rocksdb::Slice &str)
+{
+    const unsigned long long l = str.size();
+    if (l < 77 || str[0] != 0x2C) return false;
+    const char* data = str.data();
+    if (memcmp(data+1, data+21, 20) != 0) return false;
+    if (memcmp(data+21, data+41, 20) != 0) return false;
+    string t12eStrWithSigLenStr(data+61, 8);
+    string t12eStrLenStr(data+69, 8);
+    Util u;
+    unsigned long long t12eStrWithSigLen = u.byteSeqAsUll(t12eStrWithSigLenStr);
+    unsigned long long t12eStrLen = u.byteSeqAsUll(t12eStrLenStr);
+    return (t12eStrWithSigLen > t12eStrLen+8 && l == t12eStrWithSigLen+69);
+}
+
 // db must be locked for this
 CompleteID Database::getRefereeCurrency(CompleteID &pubKeyId, CompleteID &terminationID)
 {
@@ -2826,7 +3340,7 @@ Type14Entry* Database::buildNextClaim(CompleteID &pubKeyID, CompleteID &currency
     keyPref.append("TC"); // suffix for transfers to collect
     keyPref.append(currencyId.to20Char());
     unsigned long prefLength = keyPref.length();
-    rocksdb::Iterator* it = publicKeys->NewIterator(rocksdb::ReadOptions());
+    rocksdb::Iterator* it = publicKeys->NewPrefixIterator(keyPref);
     int added=0;
     for (it->Seek(keyPref); it->Valid() && added<=10; it->Next())
     {
@@ -2892,7 +3406,7 @@ Type14Entry* Database::buildNextClaim(CompleteID &pubKeyID, CompleteID &currency
             string keyMin(keyPref);
             keyMin.append(util.UlAsByteSeq(0));
             // search forward
-            it = notaries->NewIterator(rocksdb::ReadOptions());
+            it = notaries->NewPrefixIterator(keyPref);
             for (it->Seek(keyMin); it->Valid(); it->Next())
             {
                 // check the prefix
@@ -2945,65 +3459,121 @@ Type14Entry* Database::buildNextClaim(CompleteID &pubKeyID, CompleteID &currency
     return out;
 }
 
-// db must be locked for this
+// db must be locked for this (shared lock is sufficient)
 size_t Database::getExchangeOffers(CompleteID &pubKeyID, CompleteID &currencyOId, CompleteID &currencyRId, unsigned short &rangeNum, unsigned short &maxNum, list<CompleteID> &idsList)
 {
     if (!idsList.empty()) return 0;
     pubKeyID = getFirstID(pubKeyID);
-    // define prefix
-    string keyPref;
-    keyPref.push_back('I'); // suffix for key identification by id
-    unsigned long prefLength;
-    rocksdb::Iterator* it;
-    if (pubKeyID.getNotary()>0) // go to publicKeys
-    {
-        keyPref.append(pubKeyID.to20Char());
-        keyPref.append("EO"); // suffix for exchange offers
-        keyPref.append(currencyOId.to20Char());
-        keyPref.append(currencyRId.to20Char());
-        keyPref.append(util.UsAsByteSeq(rangeNum));
-        prefLength = keyPref.length();
-        it = publicKeys->NewIterator(rocksdb::ReadOptions());
-    }
-    else // go to currenciesAndObligations
-    {
-        keyPref.append(currencyOId.to20Char());
-        keyPref.append("EO"); // suffix for exchange offers
-        keyPref.append(currencyRId.to20Char());
-        keyPref.append(util.UsAsByteSeq(rangeNum));
-        prefLength = keyPref.length();
-        it = currenciesAndObligations->NewIterator(rocksdb::ReadOptions());
-    }
-    // construct list
-    for (it->Seek(keyPref); it->Valid() && idsList.size()<maxNum; it->Next())
-    {
-        // check the prefix
-        string keyStr = it->key().ToString();
-        if (keyStr.length()<=prefLength) break;
-        if (keyStr.substr(0, prefLength).compare(keyPref) != 0) break;
-        // add to list
-        string ratioAndIdStr = keyStr.substr(prefLength, keyStr.length()-prefLength);
-        if (ratioAndIdStr.length()!=28) break;
-        string idStr = ratioAndIdStr.substr(8, 20);
-        CompleteID id(idStr);
-        idsList.push_back(id);
-    }
-    delete it;
-    return idsList.size();
+    // all owners if pubKeyID is zero
+    return orderBook.getOffers(pubKeyID, currencyOId, currencyRId, rangeNum, maxNum, idsList);
 }
 
-// db must be locked for this
+// db must be locked for this (shared lock is sufficient)
+// the new ratio is applied to orderBook at once, but published and stored with persistExchangeOfferRatios
 void Database::updateExchangeOfferRatio(CompleteID &offerId, Type12Entry* offerEntry)
 {
     if (offerEntry == nullptr || offerEntry->underlyingType()!=10) return;
+    OrderBook::Offer offer;
+    if (!orderBook.getOffer(offerId, offer)) return;
     Type10Entry *t10e = (Type10Entry*) offerEntry->underlyingEntry();
     CompleteID ownerId = offerEntry->pubKeyID();
     ownerId = getFirstID(ownerId);
     CompleteID currencyOId = t10e->getCurrencyOrObl();
-    CompleteID currencyRId = t10e->getTarget();
     double amountR = t10e->getRequestedAmount();
-    if (removeFromExchangeOffersList(offerId, ownerId, currencyOId, currencyRId))
-        addToExchangeOffersList(offerId, ownerId, currencyOId, currencyRId, amountR);
+    double exchangeRatio = getExchangeOfferRatio(offerId, ownerId, currencyOId, amountR);
+    if (exchangeRatio == offer.ratio) return;
+    if (!orderBook.setRatio(offerId, exchangeRatio)) return;
+    ratioUpdates_mutex.lock();
+    ratioUpdates.insert(offerId);
+    ratioUpdates_mutex.unlock();
+}
+
+// db must be locked for this
+void Database::persistExchangeOfferRatios()
+{
+    set<CompleteID, CompleteID::CompareIDs> updates;
+    ratioUpdates_mutex.lock();
+    updates.swap(ratioUpdates);
+    ratioUpdates_mutex.unlock();
+    if (updates.empty()) return;
+    WriteBatchScope batchScope(this);
+    set<CompleteID, CompleteID::CompareIDs>::iterator it;
+    for (it=updates.begin(); it!=updates.end(); ++it)
+    {
+        CompleteID offerId = *it;
+        OrderBook::Offer offer;
+        if (!orderBook.getOffer(offerId, offer)) continue; // removed in the meantime
+        if (deleteExchangeOfferKeys(offerId, offer.ownerId, offer.currencyOId, offer.currencyRId))
+        {
+            storeExchangeOfferKeys(offerId, offer.ownerId, offer.currencyOId, offer.currencyRId, offer.range, offer.amountR, offer.ratio);
+        }
+    }
+}
+
+// loads orderBook from the exchange offers stored in publicKeys (at startup)
+void Database::initOrderBook()
+{
+    orderBook.clear();
+    ratioUpdates_mutex.lock();
+    ratioUpdates.clear();
+    ratioUpdates_mutex.unlock();
+    rocksdb::Iterator* it = publicKeys->NewPrefixIterator("I");
+    for (it->Seek("I"); it->Valid(); it->Next())
+    {
+        loadExchangeOffer(it->key());
+    }
+    delete it;
+    orderBook.publish();
+}
+
+// db must be locked for this
+// adds the offer of an exchange offer key in publicKeys to orderBook, with range and ratio as stored in the key
+bool Database::loadExchangeOffer(const rocksdb::Slice &keySlice)
+{
+    // keys: 'I' + owner + "EO" + currencyO + currencyR + range + flipped ratio + offer id
+    if (keySlice.size()!=exchangeOfferKeyLength || keySlice[21]!='E' || keySlice[22]!='O') return false;
+    CompleteID ownerId = DBKey::idAt(keySlice, 1);
+    CompleteID currencyOId = DBKey::idAt(keySlice, 23);
+    CompleteID currencyRId = DBKey::idAt(keySlice, 43);
+    string rangeStr(keySlice.data()+63, 2);
+    string ratioStr(keySlice.data()+65, 8); // as stored with ER
+    ratioStr = util.flip(ratioStr);
+    CompleteID offerId = DBKey::idAt(keySlice, 73);
+    // amount requested
+    DBKey key('B', offerId, "EORA");
+    string amountStr;
+    rocksdb::Status s = notarizationEntries->Get(rocksdb::ReadOptions(), key.slice(), &amountStr);
+    if (!(s.ok() && amountStr.length()>2)) return false;
+    orderBook.add(offerId, ownerId, currencyOId, currencyRId, util.byteSeqAsUs(rangeStr),
+                  util.byteSeqAsDbl(amountStr), util.byteSeqAsDbl(ratioStr));
+    return true;
+}
+
+// db must be locked for this
+// resets the offers written by a failed write batch to what is stored
+void Database::reloadExchangeOffers()
+{
+    map<CompleteID, OrderBook::Offer, CompleteID::CompareIDs>::iterator it;
+    for (it=exchangeOffersInBatch.begin(); it!=exchangeOffersInBatch.end(); ++it)
+    {
+        CompleteID offerId = it->first;
+        OrderBook::Offer &offer = it->second;
+        orderBook.remove(offerId);
+        // find the stored key among the offers of the owner for the currencies
+        DBKey keyPref('I', offer.ownerId, "EO"); // suffix for exchange offer
+        keyPref.add(offer.currencyOId).add(offer.currencyRId);
+        rocksdb::Iterator* keyIt = publicKeys->NewPrefixIterator(keyPref.slice());
+        for (keyIt->Seek(keyPref.slice()); keyIt->Valid() && DBKey::startsWith(keyIt->key(), keyPref); keyIt->Next())
+        {
+            if (keyIt->key().size()==exchangeOfferKeyLength && DBKey::idAt(keyIt->key(), 73) == offerId)
+            {
+                loadExchangeOffer(keyIt->key());
+                break;
+            }
+        }
+        delete keyIt;
+    }
+    exchangeOffersInBatch.clear();
 }
 
 // db must be locked for this
@@ -3021,7 +3591,7 @@ size_t Database::getTransferRequests(CompleteID &pubKeyID, CompleteID &currencyI
     string keyMax(keyPref);
     keyMax.append(maxId.to20Char());
     // construct list
-    rocksdb::Iterator* it = publicKeys->NewIterator(rocksdb::ReadOptions());
+    rocksdb::Iterator* it = publicKeys->NewPrefixIterator(keyPref);
     for (it->SeekForPrev(keyMax); it->Valid() && idsList.size()<maxNum; it->Prev())
     {
         // check the prefix
@@ -3050,7 +3620,7 @@ size_t Database::loadOutgoingShares(TNtrNr &totalNotaryNr, map<unsigned long, do
     double multipliersSum = getMultipliersSum(totalNotaryNr);
     double shareToHandOver = 1.0;
     shareToHandOver -= getShareToKeep(totalNotaryNr);
-    rocksdb::Iterator* it = notaries->NewIterator(rocksdb::ReadOptions());
+    rocksdb::Iterator* it = notaries->NewPrefixIterator(keyPref);
     for (it->Seek(keyPref); it->Valid(); it->Next())
     {
         // check the prefix
@@ -3080,7 +3650,7 @@ size_t Database::loadIncomingShares(TNtrNr &totalNotaryNr, map<unsigned long, do
     keyPref.append("ISF"); // prefix for incoming shares
     unsigned long prefLength = keyPref.length();
     // construct list
-    rocksdb::Iterator* it = notaries->NewIterator(rocksdb::ReadOptions());
+    rocksdb::Iterator* it = notaries->NewPrefixIterator(keyPref);
     for (it->Seek(keyPref); it->Valid(); it->Next())
     {
         // check the prefix
@@ -3141,7 +3711,7 @@ double Database::getCollectedFees(TNtrNr &totalNotaryNr, CompleteID &currencyID)
     keyMin.append(util.flip(util.UsAsByteSeq(0)));
     // search forward
     double sum = 0;
-    rocksdb::Iterator* it = notaries->NewIterator(rocksdb::ReadOptions());
+    rocksdb::Iterator* it = notaries->NewPrefixIterator(keyPref);
     for (it->Seek(keyMin); it->Valid(); it->Next())
     {
         // check the prefix
@@ -3432,8 +4002,107 @@ RefereeInfo* Database::getRefereeInfo(CompleteID &pubKeyID, CompleteID &currency
     return out;
 }
 
+// can be called without locking the db
+unsigned long long Database::getNotaryTenureStart(TNtrNr tNtrNr)
+{
+    return notaryTimeline.getTenureStart(tNtrNr.getLineage(), tNtrNr.getNotaryNr());
+}
+
+// db must be locked for this
+void Database::rebuildNotaryTimeline()
+{
+    vector<vector<unsigned long long>> tenureStarts;
+    unsigned short latestLin = type1entry->latestLin();
+    for (unsigned short i=1; i<=latestLin; i++)
+    {
+        vector<unsigned long long> lineage;
+        unsigned long nrOfNotInLin = getNrOfNotariesInLineage(i);
+        for (unsigned long j=1; j<=nrOfNotInLin; j++) lineage.push_back(loadNotaryTenureStart(TNtrNr(i,j)));
+        tenureStarts.push_back(lineage);
+    }
+    notaryTimeline.reset(tenureStarts);
+}
+
+// db must be locked for this
+void Database::loadDeadlineIndexes()
+{
+    // expected terminations
+    expectedTerminations.clear();
+    string keyPref("E"); // prefix for expected terminations
+    size_t prefLength=keyPref.length();
+    rocksdb::Iterator* it = scheduledActions->NewPrefixIterator(keyPref);
+    list<string> toDeleteList;
+    for (it->Seek(keyPref); it->Valid(); it->Next())
+    {
+        // check the prefix
+        string keyStr = it->key().ToString();
+        if (keyStr.substr(0, prefLength).compare(keyPref) != 0) break;
+        if (keyStr.length()!=prefLength+28)
+        {
+            toDeleteList.push_back(keyStr);
+            continue;
+        }
+        string timeStr = util.flip(keyStr.substr(prefLength, 8));
+        string idStr = keyStr.substr(prefLength+8, 20);
+        CompleteID threadId(idStr);
+        expectedTerminations.schedule(threadId, util.byteSeqAsUll(timeStr));
+    }
+    delete it;
+    list<string>::iterator it2;
+    for (it2=toDeleteList.begin(); it2!=toDeleteList.end(); ++it2)
+    {
+        scheduledActions->Delete(rocksdb::WriteOptions(), *it2);
+    }
+    // own renotarization attempts (one per entry, later duplicates are dropped)
+    renotarizationAttempts.clear();
+    toDeleteList.clear();
+    keyPref = "A"; // prefix for attempt
+    it = subjectToRenotarization->NewPrefixIterator(keyPref);
+    for (it->Seek(keyPref); it->Valid(); it->Next())
+    {
+        string keyStr = it->key().ToString();
+        if (keyStr.substr(0, prefLength).compare(keyPref) != 0) break;
+        if (keyStr.length()!=prefLength+28)
+        {
+            toDeleteList.push_back(keyStr);
+            continue;
+        }
+        string timeStr = util.flip(keyStr.substr(prefLength, 8));
+        string idStr = keyStr.substr(prefLength+8, 20);
+        CompleteID entryId(idStr);
+        unsigned long long attemptTime;
+        if (renotarizationAttempts.getDeadline(entryId, attemptTime))
+        {
+            toDeleteList.push_back(keyStr);
+            continue;
+        }
+        renotarizationAttempts.schedule(entryId, util.byteSeqAsUll(timeStr));
+    }
+    delete it;
+    for (it2=toDeleteList.begin(); it2!=toDeleteList.end(); ++it2)
+    {
+        subjectToRenotarization->Delete(rocksdb::WriteOptions(), *it2);
+    }
+    // entries with renotarization parameters (identified by their earliest time) but no own attempt
+    renotarizationSubjects.clear();
+    keyPref = "P"; // prefix for parameters
+    it = subjectToRenotarization->NewPrefixIterator(keyPref);
+    for (it->Seek(keyPref); it->Valid(); it->Next())
+    {
+        string keyStr = it->key().ToString();
+        if (keyStr.substr(0, prefLength).compare(keyPref) != 0) break;
+        if (keyStr.length()!=prefLength+21 || keyStr[prefLength+20]!='E') continue;
+        string idStr = keyStr.substr(prefLength, 20);
+        CompleteID entryId(idStr);
+        unsigned long long attemptTime;
+        if (renotarizationAttempts.getDeadline(entryId, attemptTime)) continue;
+        renotarizationSubjects.schedule(entryId, getNextRenotarizationReview(entryId, getNotariesListLength(entryId, true)));
+    }
+    delete it;
+}
+
 // db must be locked for this
-unsigned long long Database::getNotaryTenureStart(TNtrNr tNtrNr)
+unsigned long long Database::loadNotaryTenureStart(TNtrNr tNtrNr)
 {
     // check that notary exists already
     unsigned long maxNotaryNum = getNrOfNotariesInLineage(tNtrNr.getLineage());
@@ -3467,7 +4136,7 @@ CompleteID Database::getLastEssentialEntryId(CompleteID &currentRefId)
     // search backwards
     string keyStr;
     CompleteID out;
-    rocksdb::Iterator* it = essentialEntries->NewIterator(rocksdb::ReadOptions());
+    rocksdb::Iterator* it = essentialEntries->NewPrefixIterator(keyPref);
     list<string> toDeleteList;
     for (it->SeekForPrev(keyMax); it->Valid(); it->Prev())
     {
@@ -3510,7 +4179,7 @@ size_t Database::getEssentialEntries(CompleteID &minEntryId, list<CompleteID> &i
     string keyMin(keyPref);
     keyMin.append(minEntryId.to20Char());
     // construct list
-    rocksdb::Iterator* it = essentialEntries->NewIterator(rocksdb::ReadOptions());
+    rocksdb::Iterator* it = essentialEntries->NewPrefixIterator(keyPref);
     for (it->Seek(keyMin); it->Valid(); it->Next())
     {
         // check the prefix
@@ -3533,7 +4202,7 @@ size_t Database::getNotaryApplications(CompleteID &pubKeyID, bool isApplicant, u
     pubKeyID = getFirstID(pubKeyID);
     // define prefix and dbPart
     string keyPref;
-    rocksdb::DB* dbPart=nullptr;
+    DBList* dbPart=nullptr;
     if (pubKeyID.getNotary()<=0)
     {
         keyPref.push_back('B'); // prefix for body
@@ -3566,7 +4235,7 @@ size_t Database::getNotaryApplications(CompleteID &pubKeyID, bool isApplicant, u
     string keyMin(keyPref);
     keyMin.append(minApplId.to20Char());
     // construct list
-    rocksdb::Iterator* it = dbPart->NewIterator(rocksdb::ReadOptions());
+    rocksdb::Iterator* it = dbPart->NewPrefixIterator(keyPref);
     for (it->Seek(keyMin); it->Valid() && idsList.size()<maxNum; it->Next())
     {
         // check the prefix
@@ -3591,7 +4260,7 @@ size_t Database::getApplications(string type, CompleteID &pubKeyID, bool isAppli
     pubKeyID = getFirstID(pubKeyID);
     // define prefix and dbPart
     string keyPref;
-    rocksdb::DB* dbPart=nullptr;
+    DBList* dbPart=nullptr;
     if (pubKeyID.getNotary()<=0)
     {
         keyPref.push_back('I'); // prefix to identification by Id
@@ -3625,7 +4294,7 @@ size_t Database::getApplications(string type, CompleteID &pubKeyID, bool isAppli
     string keyMin(keyPref);
     keyMin.append(minApplId.to20Char());
     // construct list
-    rocksdb::Iterator* it = dbPart->NewIterator(rocksdb::ReadOptions());
+    rocksdb::Iterator* it = dbPart->NewPrefixIterator(keyPref);
     for (it->Seek(keyMin); it->Valid() && idsList.size()<maxNum; it->Next())
     {
         // check the prefix
@@ -4705,32 +5374,23 @@ size_t Database::getClaims(CompleteID &id, CompleteID &currencyId, CompleteID &m
         return 0;
     }
     CompleteID firstKeyId = getFirstID(id);
-    CompleteID zeroId;
-    // find largest possible k via binary search
-    unsigned long long a=0;
-    unsigned long long b=getClaimCount(firstKeyId, currencyId);
-    if (b==0)
-    {
-        puts("Database::getClaims: zero claim count");
-        return 0;
-    }
-    else b--;
-    while (b-a>1)
-    {
-        unsigned long long m = (a+b)/2;
-        CompleteID claimId = getClaim(firstKeyId, currencyId, m, zeroId);
-        if (claimId<maxClaimId) a=m;
-        else b=m;
-    }
-    if (getClaim(firstKeyId, currencyId, b, zeroId) > maxClaimId) b=a;
-    if (getClaim(firstKeyId, currencyId, b, zeroId) > maxClaimId) return 0;
-    // add maxClaimsNum claims beginning with b
-    for (unsigned short i=0; i<maxClaimsNum && i<=b; i++)
-    {
-        CompleteID claimId = getClaim(firstKeyId, currencyId, b-i, zeroId);
-        if (claimId.getNotary()>0) idsList.push_front(claimId);
-        else puts("Database::getClaims: bad claimId");
+    // scan the claims index backwards, starting at maxClaimId
+    DBKey keyPref('I', firstKeyId); // suffix for key identification by id
+    keyPref.add('C'); // suffix for liquidity claims
+    keyPref.add(currencyId);
+    keyPref.add('I'); // suffix for claims by id
+    const size_t prefLength = keyPref.length();
+    DBKey keyMax(keyPref);
+    keyMax.add(maxClaimId);
+    rocksdb::Iterator* it = publicKeys->NewPrefixIterator(keyPref.slice());
+    for (it->SeekForPrev(keyMax.slice()); it->Valid() && idsList.size()<maxClaimsNum; it->Prev())
+    {
+        if (it->key().size()!=prefLength+dbKeyIdLength) continue;
+        CompleteID claimId = DBKey::idAt(it->key(), prefLength);
+        // claims which did not make it into the general list (conflicts) are skipped
+        if (isInGeneralList(claimId)) idsList.push_front(claimId);
     }
+    delete it;
     return idsList.size();
 }
 
@@ -4794,9 +5454,15 @@ CompleteID Database::getCurrencyOrOblId(Type5Or15Entry* entry)
     string *charaByteSeq = entry->getByteSeq();
     key.append(util.UlAsByteSeq(charaByteSeq->length()));
     key.append(*charaByteSeq);
+    KeyFilter* filter = currenciesAndObligations->getFilter();
+    if (filter != nullptr && !filter->mayContain(key)) return CompleteID();
     rocksdb::Status s = currenciesAndObligations->Get(rocksdb::ReadOptions(), key, &value);
     const bool success = (s.ok() && value.length()>2);
-    if (!success) return CompleteID();
+    if (!success)
+    {
+        if (filter != nullptr) filter->falsePositive();
+        return CompleteID();
+    }
     CompleteID out(value);
     return out;
 }
@@ -4821,29 +5487,30 @@ unsigned long Database::getSignatureCount(CompleteID &signId, bool renot)
 // db must be locked for this
 unsigned long Database::getSignatureCount(CompleteID &signId, unsigned char l)
 {
-    string key;
     string value;
     rocksdb::Status s;
     if (l==0)
     {
-        key.push_back('B'); // prefix to distinguish from list head
-        key.append(signId.to20Char());
-        key.append("SL");
-        key.push_back('H');
-        s = notarizationEntries->Get(rocksdb::ReadOptions(), key, &value);
+        string packed;
+        if (loadPackedSignatures(signId, packed))
+        {
+            vector<rocksdb::Slice> entries;
+            if (!unpackSignatures(packed, entries)) return 0;
+            return entries.size();
+        }
+        DBKey key('B', signId, "SLH"); // suffix for head of signatures list
+        s = notarizationEntries->Get(rocksdb::ReadOptions(), key.slice(), &value);
     }
     else if (l==1)
     {
-        key.append(signId.to20Char());
-        key.append("SC"); // suffix for signature count leading to this type 13 entry
-        s = entriesInNotarization->Get(rocksdb::ReadOptions(), key, &value);
+        DBKey key;
+        key.add(signId).add("SC"); // suffix for signature count leading to this type 13 entry
+        s = entriesInNotarization->Get(rocksdb::ReadOptions(), key.slice(), &value);
     }
     else
     {
-        key.push_back('I'); // prefix for in renotarization
-        key.append(signId.to20Char());
-        key.append("SC"); // suffix for signature count leading to this type 13 entry
-        s = subjectToRenotarization->Get(rocksdb::ReadOptions(), key, &value);
+        DBKey key('I', signId, "SC"); // prefix for in renotarization, suffix for signature count
+        s = subjectToRenotarization->Get(rocksdb::ReadOptions(), key.slice(), &value);
     }
     const bool success = (s.ok() && value.length()>2);
     if (!success) return 0;
@@ -4853,19 +5520,16 @@ unsigned long Database::getSignatureCount(CompleteID &signId, unsigned char l)
 // db must be locked for this
 CompleteID Database::getFirstNotSignId(CompleteID &signId, bool renot)
 {
-    string keyPref;
-    rocksdb::DB* dbList = entriesInNotarization;
+    DBKey key;
+    DBList* dbList = entriesInNotarization;
     if (renot)
     {
-        keyPref.push_back('I'); // prefix for in renotarization
+        key.add('I'); // prefix for in renotarization
         dbList = subjectToRenotarization;
     }
-    string key;
     string value;
-    key.append(keyPref);
-    key.append(signId.to20Char());
-    key.push_back('F'); // suffix for first id
-    rocksdb::Status s = dbList->Get(rocksdb::ReadOptions(), key, &value);
+    key.add(signId).add('F'); // suffix for first id
+    rocksdb::Status s = dbList->Get(rocksdb::ReadOptions(), key.slice(), &value);
     const bool success = (s.ok() && value.length()>2);
     if (!success) return CompleteID();
     CompleteID out(value);
@@ -4875,21 +5539,18 @@ CompleteID Database::getFirstNotSignId(CompleteID &signId, bool renot)
 // db must be locked for this
 unsigned long long Database::getNotTimeLimit(CompleteID &firstSignId, bool renot)
 {
-    string key;
     string value;
     rocksdb::Status s;
     if (!renot)
     {
-        key.append(firstSignId.to20Char());
-        key.append("TL"); // suffix for time limit
-        s = entriesInNotarization->Get(rocksdb::ReadOptions(), key, &value);
+        DBKey key;
+        key.add(firstSignId).add("TL"); // suffix for time limit
+        s = entriesInNotarization->Get(rocksdb::ReadOptions(), key.slice(), &value);
     }
     else
     {
-        key.push_back('I'); // prefix for in renotarization
-        key.append(firstSignId.to20Char());
-        key.append("TL"); // suffix for time limit
-        s = subjectToRenotarization->Get(rocksdb::ReadOptions(), key, &value);
+        DBKey key('I', firstSignId, "TL"); // prefix for in renotarization, suffix for time limit
+        s = subjectToRenotarization->Get(rocksdb::ReadOptions(), key.slice(), &value);
     }
     const bool success = (s.ok() && value.length()>2);
     if (!success) return 0;
@@ -4931,54 +5592,253 @@ bool Database::loadSigningNotaries(CompleteID &notEntryId, list<unsigned long> &
 bool Database::loadType13Entries(CompleteID &notEntryId, list<Type13Entry*> &targetList)
 {
     if (targetList.size()!=0) return false;
-    string keyPrefPref;
-    keyPrefPref.push_back('B');
-    keyPrefPref.append(notEntryId.to20Char());
-    string key;
-    string value;
-    // get nr of signatures
-    key = "";
-    key.append(keyPrefPref);
-    key.append("SL");
-    key.push_back('H');
-    rocksdb::Status s = notarizationEntries->Get(rocksdb::ReadOptions(), key, &value);
-    if (!(s.ok() && value.length()>2)) return false;
-    const unsigned long nr = util.byteSeqAsUl(value);
-    // load signatures
-    for (unsigned long i=0; i<nr; i++)
+    vector<CompleteID> notEntryIds(1, notEntryId);
+    vector<list<Type13Entry*>> targetLists(1);
+    if (!loadType13Entries(notEntryIds, targetLists)) return false;
+    targetList.swap(targetLists[0]);
+    return true;
+}
+
+// db must be locked for this (shared lock is sufficient)
+// loads the signatures lists of several entries with two MultiGet calls (three if some lists are not packed yet)
+bool Database::loadType13Entries(vector<CompleteID> &notEntryIds, vector<list<Type13Entry*>> &targetLists)
+{
+    const size_t n = notEntryIds.size();
+    if (targetLists.size()!=n) return false;
+    for (size_t k=0; k<n; k++) if (targetLists[k].size()!=0) return false;
+    if (n==0) return true;
+
+    // get packed lists
+    vector<DBKey> keys;
+    keys.reserve(n);
+    vector<rocksdb::Slice> keySlices;
+    for (size_t k=0; k<n; k++)
     {
-        value = "";
-        key = "";
-        key.append(keyPrefPref);
-        key.append("SL");
-        key.push_back('B'); // suffix for body of signatures list
-        key.append(util.UlAsByteSeq(i));
-        s = notarizationEntries->Get(rocksdb::ReadOptions(), key, &value);
-        if (!(s.ok() && value.length()>2)) return false;
-        Type13Entry *t13e = new Type13Entry(value);
-        if (!t13e->isGood())
+        keys.push_back(DBKey('B', notEntryIds[k], "SP"));
+        keySlices.push_back(keys.back().slice());
+    }
+    vector<string> packed;
+    vector<rocksdb::Status> s = notarizationEntries->MultiGet(rocksdb::ReadOptions(), keySlices, &packed);
+    vector<bool> isPacked(n);
+    vector<unsigned long> nr(n, 0);
+    vector<size_t> notPacked;
+    for (size_t k=0; k<n; k++)
+    {
+        isPacked[k] = (s[k].ok() && packed[k].length()>2);
+        if (!isPacked[k]) notPacked.push_back(k);
+    }
+
+    // nr of signatures of lists not packed yet
+    if (!notPacked.empty())
+    {
+        keys.clear();
+        keys.reserve(notPacked.size());
+        keySlices.clear();
+        for (size_t j=0; j<notPacked.size(); j++)
         {
-            puts("Database::loadType13Entries: bad t13e");
-            delete t13e;
-            return false;
+            keys.push_back(DBKey('B', notEntryIds[notPacked[j]], "SLH")); // suffix for head of signatures list
+            keySlices.push_back(keys.back().slice());
+        }
+        vector<string> heads;
+        s = notarizationEntries->MultiGet(rocksdb::ReadOptions(), keySlices, &heads);
+        for (size_t j=0; j<notPacked.size(); j++)
+        {
+            if (!(s[j].ok() && heads[j].length()>2)) return false;
+            nr[notPacked[j]] = util.byteSeqAsUl(heads[j]);
         }
-        targetList.push_back(t13e);
     }
-    // load confirmation entry if existent
-    value = "";
-    key = "";
-    key.append(keyPrefPref);
-    key.append("CE");
-    s = notarizationEntries->Get(rocksdb::ReadOptions(), key, &value);
-    if (!(s.ok() && value.length()>2)) return true;
-    Type13Entry *t13e = new Type13Entry(value);
-    if (!t13e->isGood())
+    size_t keysNum = 0;
+    for (size_t k=0; k<n; k++) keysNum += nr[k] + 1;
+
+    // signatures (if not packed) and confirmation entries (if existent)
+    keys.clear();
+    keys.reserve(keysNum);
+    keySlices.clear();
+    for (size_t k=0; k<n; k++)
+    {
+        for (unsigned long i=0; i<nr[k]; i++)
+        {
+            keys.push_back(DBKey('B', notEntryIds[k], "SLB")); // suffix for body of signatures list
+            keys.back().add(util.UlAsByteSeq(i));
+            keySlices.push_back(keys.back().slice());
+        }
+        keys.push_back(DBKey('B', notEntryIds[k], "CE"));
+        keySlices.push_back(keys.back().slice());
+    }
+    vector<string> values;
+    s = notarizationEntries->MultiGet(rocksdb::ReadOptions(), keySlices, &values);
+
+    bool success = true;
+    size_t pos = 0;
+    for (size_t k=0; k<n && success; k++)
+    {
+        list<string> entriesStr;
+        if (isPacked[k])
+        {
+            vector<rocksdb::Slice> entries;
+            if (!unpackSignatures(packed[k], entries) || entries.empty())
+            {
+                success = false;
+                break;
+            }
+            for (size_t i=0; i<entries.size(); i++) entriesStr.push_back(entries[i].ToString());
+        }
+        for (unsigned long i=0; i<nr[k]; i++, pos++)
+        {
+            if (!(s[pos].ok() && values[pos].length()>2))
+            {
+                success = false;
+                break;
+            }
+            entriesStr.push_back(values[pos]);
+        }
+        if (!success) break;
+        list<string>::iterator it;
+        for (it=entriesStr.begin(); it!=entriesStr.end(); ++it)
+        {
+            Type13Entry *t13e = new Type13Entry(*it);
+            if (!t13e->isGood())
+            {
+                puts("Database::loadType13Entries: bad t13e");
+                delete t13e;
+                success = false;
+                break;
+            }
+            targetLists[k].push_back(t13e);
+        }
+        if (!success) break;
+        // confirmation entry
+        if (s[pos].ok() && values[pos].length()>2)
+        {
+            Type13Entry *t13e = new Type13Entry(values[pos]);
+            if (!t13e->isGood())
+            {
+                puts("Database::loadType13Entries: bad confirmation entry");
+                delete t13e;
+                success = false;
+                break;
+            }
+            targetLists[k].push_back(t13e);
+        }
+        pos++;
+    }
+    if (success) return true;
+    // clean up
+    for (size_t k=0; k<n; k++)
+    {
+        list<Type13Entry*>::iterator it;
+        for (it=targetLists[k].begin(); it!=targetLists[k].end(); ++it) delete *it;
+        targetLists[k].clear();
+    }
+    return false;
+}
+
+// packed format: number of entries, end offset of each entry (relative to the first entry), entries
+string Database::packSignatures(list<string> &entries)
+{
+    string header = util.UlAsByteSeq(entries.size());
+    string body;
+    list<string>::iterator it;
+    for (it=entries.begin(); it!=entries.end(); ++it)
+    {
+        body.append(*it);
+        header.append(util.UlAsByteSeq(body.length()));
+    }
+    header.append(body);
+    return header;
+}
+
+// the slices point into packed
+bool Database::unpackSignatures(const rocksdb::Slice &packed, vector<rocksdb::Slice> &entries)
+{
+    entries.clear();
+    if (packed.size()<4) return false;
+    string dum(packed.data(), 4);
+    const unsigned long n = util.byteSeqAsUl(dum);
+    const size_t headerLength = 4 + 4 * (size_t) n;
+    if (packed.size()<headerLength) return false;
+    size_t start = headerLength;
+    for (unsigned long i=0; i<n; i++)
+    {
+        dum.assign(packed.data() + 4 + 4*i, 4);
+        const size_t end = headerLength + util.byteSeqAsUl(dum);
+        if (end<start || end>packed.size()) return false;
+        entries.push_back(rocksdb::Slice(packed.data() + start, end - start));
+        start = end;
+    }
+    return (start==packed.size());
+}
+
+// db must be locked for this (shared lock is sufficient)
+bool Database::loadPackedSignatures(CompleteID &notEntryId, string &packed)
+{
+    DBKey key('B', notEntryId, "SP"); // suffix for packed signatures list
+    rocksdb::Status s = notarizationEntries->Get(rocksdb::ReadOptions(), key.slice(), &packed);
+    return (s.ok() && packed.length()>2);
+}
+
+// db must be locked for this
+// converts signature lists stored as SLH + SLB<i> into the packed format, returns false when done
+bool Database::packNextSignatureLists()
+{
+    if (!packSignatureLists || packingCursor.empty()) return false;
+    WriteBatchScope cursorScope(this); // the stored cursor only moves on with the converted lists
+    // find lists which are not packed yet
+    list<CompleteID> ids;
+    size_t count = 0;
+    rocksdb::Iterator* it = notarizationEntries->NewPrefixIterator("B");
+    for (it->Seek(packingCursor); it->Valid() && count<packingScanLimit; it->Next())
+    {
+        count++;
+        rocksdb::Slice keySlice = it->key();
+        if (keySlice.size()==24 && keySlice.ends_with("SLH")) ids.push_back(DBKey::idAt(keySlice, 1));
+    }
+    if (it->Valid()) packingCursor = it->key().ToString();
+    else packingCursor.clear();
+    delete it;
+
+    // convert
+    list<CompleteID>::iterator iter;
+    for (iter=ids.begin(); iter!=ids.end(); ++iter)
     {
-        puts("Database::loadType13Entries: bad confirmation entry");
-        delete t13e;
+        WriteBatchScope batchScope(this); // packed list replaces the old keys at once
+        DBKey key('B', *iter, "SLH");
+        DBKey packedKey('B', *iter, "SP");
+        string value;
+        rocksdb::Status s = notarizationEntries->Get(rocksdb::ReadOptions(), key.slice(), &value);
+        if (!(s.ok() && value.length()>2)) continue;
+        const unsigned long nr = util.byteSeqAsUl(value);
+        list<string> entriesStr;
+        list<DBKey> bodyKeys;
+        for (unsigned long i=0; i<nr; i++)
+        {
+            bodyKeys.push_back(DBKey('B', *iter, "SLB"));
+            bodyKeys.back().add(util.UlAsByteSeq(i));
+            value = "";
+            s = notarizationEntries->Get(rocksdb::ReadOptions(), bodyKeys.back().slice(), &value);
+            if (!(s.ok() && value.length()>2)) break;
+            entriesStr.push_back(value);
+        }
+        if (entriesStr.size()!=nr) continue;
+        notarizationEntries->Put(rocksdb::WriteOptions(), packedKey.slice(), packSignatures(entriesStr));
+        notarizationEntries->Delete(rocksdb::WriteOptions(), key.slice());
+        list<DBKey>::iterator keyIt;
+        for (keyIt=bodyKeys.begin(); keyIt!=bodyKeys.end(); ++keyIt)
+        {
+            notarizationEntries->Delete(rocksdb::WriteOptions(), keyIt->slice());
+        }
+        packedListsCount++;
+    }
+
+    if (packingCursor.empty()) scheduledActions->Put(rocksdb::WriteOptions(), packingCursorKey, packingDoneMarker);
+    else scheduledActions->Put(rocksdb::WriteOptions(), packingCursorKey, packingCursor);
+    if (packingCursor.empty())
+    {
+        string msg("Database: signature lists packed: ");
+        msg.append(to_string(packedListsCount));
+        puts(msg.c_str());
         return false;
     }
-    targetList.push_back(t13e);
     return true;
 }
 
@@ -4994,14 +5854,32 @@ void Database::saveConfirmationEntry(CompleteID &firstSignId, Type13Entry *confE
     key.append(firstSignId.to20Char());
     key.append("CE"); // confirmation entry
     notarizationEntries->Put(rocksdb::WriteOptions(), key, *confEntry->getByteSeq());
+    CompleteID firstId = getFirstID(firstSignId);
+    chainCache.erase(firstId);
+}
+
+// db must be locked for this (shared lock is sufficient)
+// a cached chain is valid as long as the latest id and the latest lineage are unchanged
+bool Database::loadCachedChain(CompleteID &firstId, string &stamp, string &chainStr)
+{
+    stamp = getLatestID(firstId).to20Char();
+    stamp.append(util.UsAsByteSeq(type1entry->latestLin()));
+    return chainCache.get(firstId, stamp, chainStr);
+}
+
+// stamp must be obtained from loadCachedChain before the chain is loaded
+void Database::cacheChain(CompleteID &firstId, string &stamp, string &chainStr)
+{
+    chainCache.put(firstId, stamp, chainStr);
 }
 
 // db must be locked for this
 bool Database::integrateNewNotEntry(CompleteID &firstSignId, bool renot, Type13Entry *confEntry)
 {
+    WriteBatchScope batchScope(this); // all changes are written at once
     // save to general list
     string keyPref;
-    rocksdb::DB* dbList = entriesInNotarization;
+    DBList* dbList = entriesInNotarization;
     if (renot)
     {
         keyPref.push_back('I'); // prefix for in renotarization
@@ -5094,6 +5972,7 @@ bool Database::integrateNewNotEntry(CompleteID &firstSignId, bool renot, Type13E
         key.append(keyPrefPref);
         key.append("LN");
         notarizationEntries->Put(rocksdb::WriteOptions(), key, firstId.to20Char());
+        latestIdCache.erase(firstId);
 
         // create UET
         key = "";
@@ -5109,6 +5988,8 @@ bool Database::integrateNewNotEntry(CompleteID &firstSignId, bool renot, Type13E
         key.append(firstId.to20Char());
         key.append("LN");
         notarizationEntries->Put(rocksdb::WriteOptions(), key, getLatestID(firstId).maximum(firstSignId).to20Char());
+        latestIdCache.erase(firstId);
+        chainCache.erase(firstId);
     }
 
     keyPrefPref = "";
@@ -5120,36 +6001,49 @@ bool Database::integrateNewNotEntry(CompleteID &firstSignId, bool renot, Type13E
     key.append(keyPrefPref);
     key.append("FN");
     notarizationEntries->Put(rocksdb::WriteOptions(), key, firstId.to20Char());
+    firstIdCache.erase(firstSignId);
 
-    // save signatures head
-    key = "";
-    key.append(keyPrefPref);
-    key.append("SL");
-    key.push_back('H');
-    notarizationEntries->Put(rocksdb::WriteOptions(), key, util.UlAsByteSeq(type13entriesStr.size()));
-
-    // save signatures body
-    unsigned int c = 0;
-    list<string>::iterator it;
-    for (it=type13entriesStr.begin(); it!=type13entriesStr.end(); ++it)
+    if (packSignatureLists)
+    {
+        // save signatures list as one value
+        key = "";
+        key.append(keyPrefPref);
+        key.append("SP"); // suffix for packed signatures list
+        notarizationEntries->Put(rocksdb::WriteOptions(), key, packSignatures(type13entriesStr));
+    }
+    else
     {
+        // save signatures head
         key = "";
         key.append(keyPrefPref);
         key.append("SL");
-        key.push_back('B');
-        key.append(util.UlAsByteSeq(c));
-        notarizationEntries->Put(rocksdb::WriteOptions(), key, *it);
-        c++;
-        // save actual entry
-        if (it==type13entriesStr.begin())
+        key.push_back('H');
+        notarizationEntries->Put(rocksdb::WriteOptions(), key, util.UlAsByteSeq(type13entriesStr.size()));
+
+        // save signatures body
+        unsigned int c = 0;
+        list<string>::iterator it;
+        for (it=type13entriesStr.begin(); it!=type13entriesStr.end(); ++it)
         {
             key = "";
             key.append(keyPrefPref);
-            key.append("AE");
+            key.append("SL");
+            key.push_back('B');
+            key.append(util.UlAsByteSeq(c));
             notarizationEntries->Put(rocksdb::WriteOptions(), key, *it);
+            c++;
         }
     }
 
+    // save actual entry
+    if (!type13entriesStr.empty())
+    {
+        key = "";
+        key.append(keyPrefPref);
+        key.append("AE");
+        notarizationEntries->Put(rocksdb::WriteOptions(), key, type13entriesStr.front());
+    }
+
     // save confirmation entry
     if (confEntry != nullptr)
     {
@@ -5223,6 +6117,7 @@ bool Database::integrateNewNotEntry(CompleteID &firstSignId, bool renot, Type13E
         key.append(totalNotaryNr.toString());
         key.append("T2E"); // prefix for type 2 entry
         notaries->Put(rocksdb::WriteOptions(), key, firstId.to20Char());
+        notaryTimeline.setTenureStart(lineage, totalNotaryNr.getNotaryNr(), loadNotaryTenureStart(totalNotaryNr));
 
         delete type12entry;
 
@@ -5349,10 +6244,7 @@ bool Database::integrateNewNotEntry(CompleteID &firstSignId, bool renot, Type13E
         unsigned long long terminationTime = processingTime;
         terminationTime *= 1000;
         terminationTime += firstSignId.getTimeStamp();
-        key="E"; // prefix for expected terminations
-        key.append(util.flip(util.UllAsByteSeq(terminationTime)));
-        key.append(firstSignId.to20Char());
-        scheduledActions->Put(rocksdb::WriteOptions(), key, firstSignId.to20Char());
+        storeExpectedTermination(firstSignId, terminationTime);
 
         delete type12entry;
         return true;
@@ -5463,10 +6355,7 @@ bool Database::integrateNewNotEntry(CompleteID &firstSignId, bool renot, Type13E
         unsigned long long terminationTime = getProcessingTime(applicationId);
         terminationTime *= 1000;
         terminationTime += firstSignId.getTimeStamp();
-        key="E"; // prefix for expected terminations
-        key.append(util.flip(util.UllAsByteSeq(terminationTime)));
-        key.append(firstSignId.to20Char());
-        scheduledActions->Put(rocksdb::WriteOptions(), key, firstSignId.to20Char());
+        storeExpectedTermination(firstSignId, terminationTime);
         deleteT9eCreationParameters(predecessorIdFirst);
 
         // increase initiated threads count if new thread
@@ -5676,10 +6565,7 @@ bool Database::integrateNewNotEntry(CompleteID &firstSignId, bool renot, Type13E
         unsigned long long terminationTime = processingTime;
         terminationTime *= 1000;
         terminationTime += firstSignId.getTimeStamp();
-        key="E"; // prefix for expected terminations
-        key.append(util.flip(util.UllAsByteSeq(terminationTime)));
-        key.append(firstSignId.to20Char());
-        scheduledActions->Put(rocksdb::WriteOptions(), key, firstSignId.to20Char());
+        storeExpectedTermination(firstSignId, terminationTime);
 
         delete type12entry;
         return true;
@@ -5783,10 +6669,7 @@ bool Database::integrateNewNotEntry(CompleteID &firstSignId, bool renot, Type13E
         unsigned long long terminationTime = type7entry->getProcessingTime();
         terminationTime *= 1000;
         terminationTime += firstSignId.getTimeStamp();
-        key="E"; // prefix for expected terminations
-        key.append(util.flip(util.UllAsByteSeq(terminationTime)));
-        key.append(firstSignId.to20Char());
-        scheduledActions->Put(rocksdb::WriteOptions(), key, firstSignId.to20Char());
+        storeExpectedTermination(firstSignId, terminationTime);
 
         delete type12entry;
         return true;
@@ -5959,10 +6842,7 @@ bool Database::integrateNewNotEntry(CompleteID &firstSignId, bool renot, Type13E
         unsigned long long terminationTime = getProcessingTime(applicationId);
         terminationTime *= 1000;
         terminationTime += firstSignId.getTimeStamp();
-        key="E"; // prefix for expected terminations
-        key.append(util.flip(util.UllAsByteSeq(terminationTime)));
-        key.append(firstSignId.to20Char());
-        scheduledActions->Put(rocksdb::WriteOptions(), key, firstSignId.to20Char());
+        storeExpectedTermination(firstSignId, terminationTime);
         deleteT9eCreationParameters(predecessorIdFirst);
 
         delete type12entry;
@@ -6791,7 +7671,7 @@ bool Database::integrateNewNotEntry(CompleteID &firstSignId, bool renot, Type13E
 void Database::deleteTailSignatures(CIDsSet &ids, bool renot)
 {
     string keyPref;
-    rocksdb::DB* dbList = entriesInNotarization;
+    DBList* dbList = entriesInNotarization;
     if (renot)
     {
         keyPref.push_back('I'); // prefix for in renotarization
@@ -6840,7 +7720,7 @@ CompleteID Database::deleteSignatures(CompleteID &firstSignId, bool renot)
 {
     CompleteID out;
     string keyPref;
-    rocksdb::DB* dbList = entriesInNotarization;
+    DBList* dbList = entriesInNotarization;
     if (renot)
     {
         keyPref.push_back('I'); // prefix for in renotarization
@@ -6953,6 +7833,52 @@ CompleteID Database::deleteSignatures(CompleteID &firstSignId, bool renot)
 // db must be locked for this
 bool Database::removeFromExchangeOffersList(CompleteID &offerId, CompleteID &ownerId, CompleteID &currencyOId, CompleteID &currencyRId)
 {
+    orderBook.remove(offerId);
+    if (writeBatch == nullptr) orderBook.publish(); // otherwise published when the batch is committed
+    return deleteExchangeOfferKeys(offerId, ownerId, currencyOId, currencyRId);
+}
+
+// db must be locked for this
+void Database::addToExchangeOffersList(CompleteID &offerId, CompleteID &ownerId, CompleteID &currencyOId, CompleteID &currencyRId, double amountR)
+{
+    unsigned short range = getExchangeOfferRange(currencyRId, amountR);
+    double exchangeRatio = getExchangeOfferRatio(offerId, ownerId, currencyOId, amountR);
+    storeExchangeOfferKeys(offerId, ownerId, currencyOId, currencyRId, range, amountR, exchangeRatio);
+    orderBook.add(offerId, ownerId, currencyOId, currencyRId, range, amountR, exchangeRatio);
+    if (writeBatch == nullptr) orderBook.publish(); // otherwise published when the batch is committed
+}
+
+// db must be locked for this (shared lock is sufficient)
+unsigned short Database::getExchangeOfferRange(CompleteID &currencyRId, double amountR)
+{
+    double minTransfer = getLowerTransferLimit(currencyRId);
+    if (minTransfer<=0) minTransfer=0.01;
+    return util.getRange(amountR, minTransfer);
+}
+
+// db must be locked for this (shared lock is sufficient)
+double Database::getExchangeOfferRatio(CompleteID &offerId, CompleteID &ownerId, CompleteID &currencyOId, double amountR)
+{
+    double discountRate = getDiscountRate(currencyOId);
+    CompleteID zeroId;
+    double carriedAmount = getCollectableLiquidity(offerId, ownerId, currencyOId, discountRate, 1, zeroId, systemTimeInMs());
+    return amountR/carriedAmount;
+}
+
+// db must be locked for this
+void Database::noteExchangeOfferInBatch(CompleteID &offerId, CompleteID &ownerId, CompleteID &currencyOId, CompleteID &currencyRId)
+{
+    OrderBook::Offer &offer = exchangeOffersInBatch[offerId];
+    offer.id = offerId;
+    offer.ownerId = ownerId;
+    offer.currencyOId = currencyOId;
+    offer.currencyRId = currencyRId;
+}
+
+// db must be locked for this
+bool Database::deleteExchangeOfferKeys(CompleteID &offerId, CompleteID &ownerId, CompleteID &currencyOId, CompleteID &currencyRId)
+{
+    if (writeBatch != nullptr) noteExchangeOfferInBatch(offerId, ownerId, currencyOId, currencyRId);
     // get amount requested
     string key;
     string value;
@@ -6967,9 +7893,7 @@ bool Database::removeFromExchangeOffersList(CompleteID &offerId, CompleteID &own
     // remove amount requested
     notarizationEntries->Delete(rocksdb::WriteOptions(), key);
     // calculate range
-    double minTransfer = getLowerTransferLimit(currencyRId);
-    if (minTransfer<=0) minTransfer=0.01;
-    unsigned short range = util.getRange(amountR, minTransfer);
+    unsigned short range = getExchangeOfferRange(currencyRId, amountR);
     // get stored exchange rate
     key="";
     value="";
@@ -7008,17 +7932,10 @@ bool Database::removeFromExchangeOffersList(CompleteID &offerId, CompleteID &own
 }
 
 // db must be locked for this
-void Database::addToExchangeOffersList(CompleteID &offerId, CompleteID &ownerId, CompleteID &currencyOId, CompleteID &currencyRId, double amountR)
+void Database::storeExchangeOfferKeys(CompleteID &offerId, CompleteID &ownerId, CompleteID &currencyOId, CompleteID &currencyRId,
+                                      unsigned short range, double amountR, double exchangeRatio)
 {
-    // get range
-    double minTransfer = getLowerTransferLimit(currencyRId);
-    if (minTransfer<=0) minTransfer=0.01;
-    unsigned short range = util.getRange(amountR, minTransfer);
-    // get exchange ratio
-    double discountRate = getDiscountRate(currencyOId);
-    CompleteID zeroId;
-    double carriedAmount = getCollectableLiquidity(offerId, ownerId, currencyOId, discountRate, 1, zeroId, systemTimeInMs());
-    double exchangeRatio = amountR/carriedAmount;
+    if (writeBatch != nullptr) noteExchangeOfferInBatch(offerId, ownerId, currencyOId, currencyRId);
     // store exchange rate to main list
     string key="";
     key.push_back('B'); // prefix to distinguish from list head
@@ -7086,7 +8003,7 @@ bool Database::addInitialSignature(Type13Entry* entry, Type12Entry* type12entry)
     }
 
     string keyPref;
-    rocksdb::DB* dbList = entriesInNotarization;
+    DBList* dbList = entriesInNotarization;
     string key;
     string value;
     if (type12entry == nullptr) // if renotarization
@@ -7278,6 +8195,11 @@ bool Database::addInitialSignature(Type13Entry* entry, Type12Entry* type12entry)
             key.push_back('B'); // suffix for body
             key.append(util.UllAsByteSeq(claimCount));
             publicKeys->Put(rocksdb::WriteOptions(), key, firstId.to20Char());
+            // index claim by id
+            key.resize(key.length()-9);
+            key.push_back('I'); // suffix for claims by id
+            key.append(firstId.to20Char());
+            publicKeys->Put(rocksdb::WriteOptions(), key, firstId.to20Char());
             // store collecting claims for predecessors
             const unsigned short predecessorCount = type14entry->getPredecessorsCount();
             for (unsigned short i=0; i<predecessorCount; i++)
@@ -7357,11 +8279,14 @@ bool Database::addInitialSignature(Type13Entry* entry, Type12Entry* type12entry)
 // db must be locked for this
 bool Database::isConflicting(CompleteID &firstID)
 {
-    string key;
+    DBKey key;
+    key.add(firstID);
     string value;
-    key.append(firstID.to20Char());
-    rocksdb::Status s = conflicts->Get(rocksdb::ReadOptions(), key, &value);
+    KeyFilter* filter = conflicts->getFilter();
+    if (filter != nullptr && !filter->mayContain(key.slice())) return false;
+    rocksdb::Status s = conflicts->Get(rocksdb::ReadOptions(), key.slice(), &value);
     const bool success = (s.ok() && value.length()>2);
+    if (!success && filter != nullptr) filter->falsePositive();
     return success;
 }
 
@@ -7454,7 +8379,7 @@ bool Database::addNextSignature(Type13Entry* entry, bool renot)
     string keyPref;
     string key;
     string value;
-    rocksdb::DB* dbList = entriesInNotarization;
+    DBList* dbList = entriesInNotarization;
     if (renot)
     {
         keyPref.push_back('I'); // prefix for in renotarization
@@ -7569,6 +8494,32 @@ bool Database::loadType13EntryStr(CompleteID &entryId, unsigned char l, string &
     return (s.ok() && str.length()>2);
 }
 
+// db must be locked for this (shared lock is sufficient)
+// like loadType13EntryStr, but the value is pinned instead of copied
+bool Database::loadType13EntryPinned(CompleteID &entryId, unsigned char l, rocksdb::PinnableSlice &value)
+{
+    value.Reset();
+    rocksdb::Status s;
+    if (l==0)
+    {
+        DBKey key('B', entryId, "AE"); // suffix for actual entry
+        s = notarizationEntries->Get(rocksdb::ReadOptions(), key.slice(), &value);
+    }
+    else if (l==1)
+    {
+        DBKey key;
+        key.add(entryId);
+        key.add("AE"); // suffix for actual entry
+        s = entriesInNotarization->Get(rocksdb::ReadOptions(), key.slice(), &value);
+    }
+    else
+    {
+        DBKey key('I', entryId, "AE"); // prefix for in renotarization, suffix for actual entry
+        s = subjectToRenotarization->Get(rocksdb::ReadOptions(), key.slice(), &value);
+    }
+    return (s.ok() && value.size()>2);
+}
+
 // db must be locked for this
 bool Database::verifySignature(string &signedSequence, string &signatureStr, unsigned long notaryNum, unsigned long long timeStamp)
 {
@@ -7609,7 +8560,7 @@ size_t Database::getExistingEntriesIds(CompleteID &id, list<CompleteID> &idsList
     if (idsList.size()>0) return 0;
 
     string keyPref;
-    rocksdb::DB* dbList = entriesInNotarization;
+    DBList* dbList = entriesInNotarization;
     if (renot)
     {
         keyPref.push_back('I'); // prefix for in renotarization
@@ -7639,10 +8590,28 @@ size_t Database::getExistingEntriesIds(CompleteID &id, list<CompleteID> &idsList
     return idsList.size();
 }
 
+// db must be locked for this
+// all entries are written at once, entries which could not be added are deleted and removed from the list
+void Database::addType13Entries(list<Type13Entry*> &entries)
+{
+    WriteBatchScope batchScope(this);
+    list<Type13Entry*>::iterator it = entries.begin();
+    while (it != entries.end())
+    {
+        if (addType13Entry(*it, false)) ++it;
+        else
+        {
+            delete *it;
+            it = entries.erase(it);
+        }
+    }
+}
+
 // db must be locked for this
 bool Database::addType13Entry(Type13Entry* entry, bool integrateIfPossible)
 {
     if (entry == nullptr || !entry->isGood()) return false;
+    WriteBatchScope batchScope(this); // all changes are written at once
     conflictingEntries.clear();
     // do some basic checks
     CompleteID entryID = entry->getCompleteID();
@@ -7880,7 +8849,7 @@ bool Database::addType13Entry(Type13Entry* entry, bool integrateIfPossible)
     if (predSourceType == 1 || predSourceType == 2)
     {
         string key;
-        rocksdb::DB* dbList = entriesInNotarization;
+        DBList* dbList = entriesInNotarization;
         if (renot)
         {
             key.push_back('I'); // prefix for in renotarization
@@ -8135,36 +9104,8 @@ bool Database::addType13Entry(Type13Entry* entry, bool integrateIfPossible)
     }
 
     // clean up download schedule
-    if (lastDownloadAttempt.count(firstID)>0)
-    {
-        lastDownloadAttempt.erase(firstID);
-    }
-    if (missingPredecessors.count(firstID)>0)
-    {
-        delete missingPredecessors[firstID];
-        missingPredecessors.erase(firstID);
-    }
-    if (missingNotaries.count(firstID)>0)
-    {
-        delete missingNotaries[firstID];
-        missingNotaries.erase(firstID);
-    }
-    DownloadStatus* status;
-    map<CompleteID, DownloadStatus*, CompleteID::CompareIDs> *entriesInD =
-        (map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>*)entriesInDownload;
-    map<CompleteID, DownloadStatus*, CompleteID::CompareIDs> *entriesToD =
-        (map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>*)entriesToDownload;
-    if ((*entriesToD).count(firstID)>0)
-    {
-        status = (*entriesToD)[firstID];
-        (*entriesToD).erase(firstID);
-    }
-    else if ((*entriesInD).count(firstID)>0)
-    {
-        status = (*entriesInD)[firstID];
-        (*entriesInD).erase(firstID);
-    }
-    else return true;
+    set<pair<unsigned char,unsigned long>> neededFor;
+    if (!downloads.remove(firstID, &neededFor)) return true;
 
     getUpToDateID(0);
     getUpToDateID(1);
@@ -8173,7 +9114,7 @@ bool Database::addType13Entry(Type13Entry* entry, bool integrateIfPossible)
     getUpToDateID(4);
 
     set<pair<unsigned char,unsigned long>>::iterator it;
-    for (it = status->neededFor.begin(); it != status->neededFor.end(); ++it)
+    for (it = neededFor.begin(); it != neededFor.end(); ++it)
     {
         UpToDateTimeInfo* info = getInfoFromType(it->first);
         unsigned long notary = it->second;
@@ -8189,7 +9130,6 @@ bool Database::addType13Entry(Type13Entry* entry, bool integrateIfPossible)
             }
         }
     }
-    delete status;
 
     if (correctUpToDateTime(listEssentials)) saveUpToDateTime(0);
     if (correctUpToDateTime(listGeneral)) saveUpToDateTime(1);
@@ -8210,6 +9150,8 @@ void Database::updateIndividualUpToDate(UpToDateTimeInfo* info, unsigned long no
     info->individualUpToDatesByID.insert(pair<CompleteID,unsigned long>(id, notary));
     CompleteID zeroID(0,0,0);
     info->getUpToDateIDOverall()->resetTo(zeroID); // upToDateIDOverall has to be recalculated
+    // publish as soon as the db might have become up-to-date
+    if (scheduler != nullptr && !nodeStatus.isUpToDate()) scheduler->trigger(taskPublishNodeStatus);
 }
 
 // db to be locked for this
@@ -8268,6 +9210,16 @@ Database::UpToDateTimeInfo* Database::getInfoFromType(unsigned char listType)
     else return nullptr;
 }
 
+// db to be locked for this
+// returns zero if the notary is not followed
+CompleteID Database::getIndividualUpToDateID(unsigned char listType, unsigned long notary)
+{
+    getUpToDateID(listType);
+    UpToDateTimeInfo* info=getInfoFromType(listType);
+    if (info==nullptr || info->individualUpToDates.count(notary)<=0) return CompleteID(0,0,0);
+    return info->individualUpToDates[notary];
+}
+
 // db to be locked for this
 // returns new individual up-to-date-id or zero if need to download
 CompleteID Database::newEntriesIdsReport(unsigned char listType, unsigned long notary, CompleteID id1, CompleteID id2)
@@ -8377,91 +9329,38 @@ CompleteID Database::newEntriesIdsReport(unsigned char listType, unsigned long n
 // db to be locked for this
 void Database::addToMissingPredecessors(CompleteID &id, CompleteID &idMissing)
 {
-    if (missingPredecessors.count(id)<=0)
-    {
-        CIDsSet* newSet = new CIDsSet();
-        missingPredecessors.insert(pair<CompleteID, CIDsSet*>(id, newSet));
-    }
-    missingPredecessors[id]->add(idMissing);
+    downloads.addMissingPredecessor(id, idMissing);
 }
 
 // db to be locked for this
 void Database::addToMissingNotaries(CompleteID &id, unsigned long notaryNr)
 {
-    if (missingNotaries.count(id)<=0)
-    {
-        set<unsigned long>* newSet = new set<unsigned long>();
-        missingNotaries.insert(pair<CompleteID, set<unsigned long>*>(id, newSet));
-    }
-    if (missingNotaries[id]->count(notaryNr) > 0) return;
-    missingNotaries[id]->insert(notaryNr);
+    downloads.addMissingNotary(id, notaryNr);
 }
 
 // db to be locked for this
 void Database::insertEntryToDownload(CompleteID &id, unsigned char listType, unsigned long notary)
 {
-    map<CompleteID, DownloadStatus*, CompleteID::CompareIDs> *entriesInD =
-        (map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>*)entriesInDownload;
-    map<CompleteID, DownloadStatus*, CompleteID::CompareIDs> *entriesToD =
-        (map<CompleteID, DownloadStatus*, CompleteID::CompareIDs>*)entriesToDownload;
-    pair<unsigned char,unsigned long> listNotaryPair(listType,notary);
-    if ((*entriesToD).count(id)>0)
-    {
-        if (notary>0 && (*entriesToD)[id]->neededFor.count(listNotaryPair)<=0)
-            (*entriesToD)[id]->neededFor.insert(listNotaryPair);
-    }
-    else if ((*entriesInD).count(id)>0)
-    {
-        if (notary>0 && (*entriesInD)[id]->neededFor.count(listNotaryPair)<=0)
-            (*entriesInD)[id]->neededFor.insert(listNotaryPair);
-    }
-    else
-    {
-        while ((*entriesToD).size() + (*entriesInD).size() > maxEntriesToDownload)
-        {
-            // delete entry with largest id
-            // first determine map and largest id
-            map<CompleteID, DownloadStatus*, CompleteID::CompareIDs> *mapToDeleteFrom = entriesToD;
-            if (mapToDeleteFrom->size() <= 0) mapToDeleteFrom = entriesInD;
-            else if (entriesInD->size() > 0)
-            {
-                CompleteID candidate1=mapToDeleteFrom->rbegin()->first;
-                CompleteID candidate2=entriesInD->rbegin()->first;
-                if (candidate2>candidate1) mapToDeleteFrom = entriesInD;
-            }
-            CompleteID idToDelete = mapToDeleteFrom->rbegin()->first;
-            DownloadStatus* status = mapToDeleteFrom->rbegin()->second;
-            // delete id and status etc.
-            delete status;
-            mapToDeleteFrom->erase(idToDelete);
-            if (lastDownloadAttempt.count(idToDelete)>0)
-            {
-                lastDownloadAttempt.erase(idToDelete);
-            }
-            if (missingPredecessors.count(idToDelete)>0)
-            {
-                delete missingPredecessors[idToDelete];
-                missingPredecessors.erase(idToDelete);
-            }
-            if (missingNotaries.count(idToDelete)>0)
-            {
-                delete missingNotaries[idToDelete];
-                missingNotaries.erase(idToDelete);
-            }
-        }
-        DownloadStatus* newDownloadStatus = new DownloadStatus();
-        newDownloadStatus->attempts = 0;
-        if (notary>0) newDownloadStatus->neededFor.insert(listNotaryPair);
-        (*entriesToD).insert(pair<CompleteID,DownloadStatus*>(id,newDownloadStatus));
-    }
+    if (downloads.add(id, listType, notary) && scheduler != nullptr) scheduler->trigger(taskDownloadNewEntries);
 }
 
 void Database::lock()
 {
-    db_mutex.lock();
+    pthread_rwlock_wrlock(&db_rwlock);
 }
 
 void Database::unlock()
 {
-    db_mutex.unlock();
+    pthread_rwlock_unlock(&db_rwlock);
+}
+
+// for functions which do not change the db content (apart from removing obsolete keys)
+void Database::lockShared()
+{
+    pthread_rwlock_rdlock(&db_rwlock);
+}
+
+void Database::unlockShared()
+{
+    pthread_rwlock_unlock(&db_rwlock);
 }
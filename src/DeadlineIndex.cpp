@@ -0,0 +1,74 @@
+#include "DeadlineIndex.h"
+
+DeadlineIndex::DeadlineIndex()
+{
+
+}
+
+DeadlineIndex::~DeadlineIndex()
+{
+
+}
+
+void DeadlineIndex::clear()
+{
+    byId.clear();
+    deadlines.clear();
+}
+
+void DeadlineIndex::schedule(CompleteID &id, unsigned long long deadline)
+{
+    remove(id);
+    multimap<unsigned long long, CompleteID>::iterator it;
+    it = deadlines.insert(pair<unsigned long long, CompleteID>(deadline, id));
+    byId.insert(pair<CompleteID, multimap<unsigned long long, CompleteID>::iterator>(id, it));
+}
+
+void DeadlineIndex::remove(CompleteID &id)
+{
+    map<CompleteID, multimap<unsigned long long, CompleteID>::iterator, CompleteID::CompareIDs>::iterator it = byId.find(id);
+    if (it == byId.end()) return;
+    deadlines.erase(it->second);
+    byId.erase(it);
+}
+
+bool DeadlineIndex::getDeadline(CompleteID &id, unsigned long long &deadline)
+{
+    map<CompleteID, multimap<unsigned long long, CompleteID>::iterator, CompleteID::CompareIDs>::iterator it = byId.find(id);
+    if (it == byId.end()) return false;
+    deadline = it->second->first;
+    return true;
+}
+
+// deadlines up to and including time are due
+bool DeadlineIndex::takeDue(unsigned long long time, CompleteID &id, unsigned long long &deadline)
+{
+    if (deadlines.empty() || deadlines.begin()->first > time) return false;
+    deadline = deadlines.begin()->first;
+    id = deadlines.begin()->second;
+    byId.erase(id);
+    deadlines.erase(deadlines.begin());
+    return true;
+}
+
+size_t DeadlineIndex::size()
+{
+    return byId.size();
+}
+
+unsigned long long DeadlineIndex::getEarliest()
+{
+    if (deadlines.empty()) return ULLONG_MAX;
+    return deadlines.begin()->first;
+}
+
+void DeadlineIndex::report(string &msg)
+{
+    msg.append("scheduled: ");
+    msg.append(to_string(byId.size()));
+    if (!deadlines.empty())
+    {
+        msg.append(", earliest deadline: ");
+        msg.append(to_string(deadlines.begin()->first));
+    }
+}
@@ -0,0 +1,216 @@
+#include "DownloadScheduler.h"
+
+DownloadScheduler::DownloadScheduler(size_t maxEntries, unsigned long long retryDelayInMs)
+    : maxNodes(maxEntries), retryDelay(retryDelayInMs)
+{
+
+}
+
+DownloadScheduler::~DownloadScheduler()
+{
+    map<CompleteID, Node*, CompleteID::CompareIDs>::iterator it;
+    for (it=nodes.begin(); it!=nodes.end(); ++it)
+    {
+        delete it->second;
+    }
+    nodes.clear();
+}
+
+DownloadScheduler::Node* DownloadScheduler::getNode(CompleteID &id)
+{
+    map<CompleteID, Node*, CompleteID::CompareIDs>::iterator it = nodes.find(id);
+    if (it == nodes.end()) return nullptr;
+    return it->second;
+}
+
+void DownloadScheduler::unqueue(Node* node)
+{
+    if (node->state == stateReady) readyQueue.erase(node->readyIt);
+    else if (node->state == stateWaiting) retries.erase(node->retryIt);
+}
+
+void DownloadScheduler::makeReady(CompleteID &id, Node* node)
+{
+    node->state = stateReady;
+    node->readyIt = readyQueue.insert(readyQueue.end(), id);
+}
+
+// earliest retry after the last attempt, immediately if never attempted
+void DownloadScheduler::scheduleRetry(CompleteID &id, Node* node)
+{
+    if (node->lastAttempt == 0)
+    {
+        makeReady(id, node);
+        return;
+    }
+    node->state = stateWaiting;
+    node->retryIt = retries.insert(pair<unsigned long long, CompleteID>(node->lastAttempt + retryDelay, id));
+}
+
+// if full, the entry with the largest id is dropped
+bool DownloadScheduler::add(CompleteID &id, unsigned char listType, unsigned long notary)
+{
+    pair<unsigned char,unsigned long> listNotaryPair(listType,notary);
+    Node* node = getNode(id);
+    if (node != nullptr)
+    {
+        if (notary>0) node->neededFor.insert(listNotaryPair);
+        return false;
+    }
+    while (nodes.size() >= maxNodes && !nodes.empty())
+    {
+        CompleteID idToDelete = nodes.rbegin()->first;
+        remove(idToDelete, nullptr);
+    }
+    node = new Node();
+    node->attempts = 0;
+    node->lastAttempt = 0;
+    if (notary>0) node->neededFor.insert(listNotaryPair);
+    nodes.insert(pair<CompleteID, Node*>(id, node));
+    makeReady(id, node);
+    return true;
+}
+
+// only predecessors which are scheduled themselves block the entry
+void DownloadScheduler::addMissingPredecessor(CompleteID &id, CompleteID &predecessor)
+{
+    if (id == predecessor) return;
+    Node* node = getNode(id);
+    Node* predecessorNode = getNode(predecessor);
+    if (node == nullptr || predecessorNode == nullptr) return;
+    node->predecessors.insert(predecessor);
+    predecessorNode->dependents.insert(id);
+    if (node->state == stateReady || node->state == stateWaiting)
+    {
+        unqueue(node);
+        node->state = stateBlocked;
+    }
+}
+
+void DownloadScheduler::addMissingNotary(CompleteID &id, unsigned long notaryNr)
+{
+    Node* node = getNode(id);
+    if (node == nullptr) return;
+    node->missingNotaries.insert(notaryNr);
+}
+
+// the entry taken must be passed to attempted or remove afterwards
+bool DownloadScheduler::takeNextReady(unsigned long long currentTime, CompleteID &id)
+{
+    // retries which are due
+    while (!retries.empty() && retries.begin()->first <= currentTime)
+    {
+        CompleteID retryId = retries.begin()->second;
+        retries.erase(retries.begin());
+        makeReady(retryId, getNode(retryId));
+    }
+    if (readyQueue.empty()) return false;
+    id = readyQueue.front();
+    readyQueue.pop_front();
+    getNode(id)->state = stateTaken;
+    return true;
+}
+
+unsigned char DownloadScheduler::getAttempts(CompleteID &id)
+{
+    Node* node = getNode(id);
+    if (node == nullptr) return 0;
+    return node->attempts;
+}
+
+// nullptr if not scheduled, the set can be changed
+set<unsigned long>* DownloadScheduler::getMissingNotaries(CompleteID &id)
+{
+    Node* node = getNode(id);
+    if (node == nullptr) return nullptr;
+    return &node->missingNotaries;
+}
+
+void DownloadScheduler::attempted(CompleteID &id, unsigned long long currentTime)
+{
+    Node* node = getNode(id);
+    if (node == nullptr) return;
+    unqueue(node);
+    node->attempts++;
+    node->lastAttempt = currentTime;
+    if (node->predecessors.empty()) scheduleRetry(id, node);
+    else node->state = stateBlocked;
+}
+
+// for downloaded or dropped entries, entries waiting for it are unblocked
+bool DownloadScheduler::remove(CompleteID &id, set<pair<unsigned char,unsigned long>> *neededFor)
+{
+    map<CompleteID, Node*, CompleteID::CompareIDs>::iterator it = nodes.find(id);
+    if (it == nodes.end()) return false;
+    Node* node = it->second;
+    nodes.erase(it);
+    unqueue(node);
+    set<CompleteID, CompleteID::CompareIDs>::iterator depIt;
+    for (depIt=node->dependents.begin(); depIt!=node->dependents.end(); ++depIt)
+    {
+        CompleteID dependentId = *depIt;
+        Node* dependent = getNode(dependentId);
+        if (dependent == nullptr) continue;
+        dependent->predecessors.erase(id);
+        if (dependent->predecessors.empty() && dependent->state == stateBlocked) scheduleRetry(dependentId, dependent);
+    }
+    for (depIt=node->predecessors.begin(); depIt!=node->predecessors.end(); ++depIt)
+    {
+        CompleteID predecessorId = *depIt;
+        Node* predecessor = getNode(predecessorId);
+        if (predecessor != nullptr) predecessor->dependents.erase(id);
+    }
+    if (neededFor != nullptr) neededFor->swap(node->neededFor);
+    delete node;
+    return true;
+}
+
+size_t DownloadScheduler::size()
+{
+    return nodes.size();
+}
+
+CompleteID DownloadScheduler::getOldest()
+{
+    if (nodes.empty()) return CompleteID(0,0,0);
+    return nodes.begin()->first;
+}
+
+// ULLONG_MAX if no retry is scheduled
+unsigned long long DownloadScheduler::getNextRetryTime()
+{
+    if (retries.empty()) return ULLONG_MAX;
+    return retries.begin()->first;
+}
+
+// ids with the lists and notaries they are needed for
+void DownloadScheduler::loadEntries(map<CompleteID, set<pair<unsigned char,unsigned long>>, CompleteID::CompareIDs> &entries)
+{
+    map<CompleteID, Node*, CompleteID::CompareIDs>::iterator it;
+    for (it=nodes.begin(); it!=nodes.end(); ++it)
+    {
+        entries.insert(pair<CompleteID, set<pair<unsigned char,unsigned long>>>(it->first, it->second->neededFor));
+    }
+}
+
+void DownloadScheduler::report(string &msg)
+{
+    size_t statesCount[4] = {0, 0, 0, 0};
+    size_t missingNotariesCount = 0;
+    map<CompleteID, Node*, CompleteID::CompareIDs>::iterator it;
+    for (it=nodes.begin(); it!=nodes.end(); ++it)
+    {
+        statesCount[it->second->state]++;
+        if (!it->second->missingNotaries.empty()) missingNotariesCount++;
+    }
+    msg.append("entries to download: ");
+    msg.append(to_string(nodes.size()));
+    msg.append("\nready: ");
+    msg.append(to_string(statesCount[stateReady]));
+    msg.append("\nwaiting for retry: ");
+    msg.append(to_string(statesCount[stateWaiting]));
+    msg.append("\nwaiting for predecessors: ");
+    msg.append(to_string(statesCount[stateBlocked]));
+    msg.append("\nwaiting for notaries: ");
+    msg.append(to_string(missingNotariesCount));
+}
@@ -0,0 +1,126 @@
+#include "IDCache.h"
+
+IDCache::IDCache(size_t maxSizeInBytes)
+{
+    for (size_t i=0; i<idCacheShardsNum; i++)
+    {
+        shards[i].hits = 0;
+        shards[i].misses = 0;
+    }
+    setMaxSize(maxSizeInBytes);
+}
+
+IDCache::~IDCache()
+{
+    clear();
+}
+
+IDCache::Shard* IDCache::getShard(const string &key)
+{
+    return &shards[hash<string>()(key) % idCacheShardsNum];
+}
+
+bool IDCache::get(CompleteID &id, CompleteID &target)
+{
+    string key = id.to20Char();
+    Shard* shard = getShard(key);
+    shard->shard_mutex.lock();
+    unordered_map<string, list<pair<string, string>>::iterator>::iterator it = shard->entryByKey.find(key);
+    if (it == shard->entryByKey.end())
+    {
+        shard->misses++;
+        shard->shard_mutex.unlock();
+        return false;
+    }
+    shard->hits++;
+    shard->entries.splice(shard->entries.begin(), shard->entries, it->second);
+    string value = it->second->second;
+    shard->shard_mutex.unlock();
+    target = CompleteID(value);
+    return true;
+}
+
+void IDCache::put(CompleteID &id, CompleteID &value)
+{
+    if (maxEntriesPerShard == 0) return;
+    string key = id.to20Char();
+    Shard* shard = getShard(key);
+    shard->shard_mutex.lock();
+    unordered_map<string, list<pair<string, string>>::iterator>::iterator it = shard->entryByKey.find(key);
+    if (it != shard->entryByKey.end())
+    {
+        it->second->second = value.to20Char();
+        shard->entries.splice(shard->entries.begin(), shard->entries, it->second);
+    }
+    else
+    {
+        shard->entries.push_front(pair<string, string>(key, value.to20Char()));
+        shard->entryByKey.insert(pair<string, list<pair<string, string>>::iterator>(key, shard->entries.begin()));
+        while (shard->entries.size() > maxEntriesPerShard)
+        {
+            shard->entryByKey.erase(shard->entries.back().first);
+            shard->entries.pop_back();
+        }
+    }
+    shard->shard_mutex.unlock();
+}
+
+void IDCache::erase(CompleteID &id)
+{
+    string key = id.to20Char();
+    Shard* shard = getShard(key);
+    shard->shard_mutex.lock();
+    unordered_map<string, list<pair<string, string>>::iterator>::iterator it = shard->entryByKey.find(key);
+    if (it != shard->entryByKey.end())
+    {
+        shard->entries.erase(it->second);
+        shard->entryByKey.erase(it);
+    }
+    shard->shard_mutex.unlock();
+}
+
+void IDCache::clear()
+{
+    for (size_t i=0; i<idCacheShardsNum; i++)
+    {
+        shards[i].shard_mutex.lock();
+        shards[i].entryByKey.clear();
+        shards[i].entries.clear();
+        shards[i].shard_mutex.unlock();
+    }
+}
+
+// entries above the new limit are removed with the next insertions
+void IDCache::setMaxSize(size_t maxSizeInBytes)
+{
+    maxEntriesPerShard = maxSizeInBytes / idCacheEntrySize / idCacheShardsNum;
+    if (maxEntriesPerShard == 0) clear();
+}
+
+void IDCache::report(string &msg)
+{
+    unsigned long long hits = 0;
+    unsigned long long misses = 0;
+    size_t entriesNum = 0;
+    for (size_t i=0; i<idCacheShardsNum; i++)
+    {
+        shards[i].shard_mutex.lock();
+        hits += shards[i].hits;
+        misses += shards[i].misses;
+        entriesNum += shards[i].entries.size();
+        shards[i].shard_mutex.unlock();
+    }
+    msg.append("entries: ");
+    msg.append(to_string(entriesNum));
+    msg.append(" (max: ");
+    msg.append(to_string(maxEntriesPerShard * idCacheShardsNum));
+    msg.append("), hits: ");
+    msg.append(to_string(hits));
+    msg.append(", misses: ");
+    msg.append(to_string(misses));
+    if (hits+misses > 0)
+    {
+        msg.append(", hit rate: ");
+        msg.append(to_string((double) hits / (hits+misses)));
+    }
+}
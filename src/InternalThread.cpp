@@ -1,8 +1,10 @@
 #include "InternalThread.h"
 
-#define routineSleepTimeInMcrS 10000
-
-#define checkNewEntriesInterval 400 // in ms
+#define checkNewEntriesInterval 400 // in ms, while not up-to-date
+#define checkNewEntriesFallbackInterval 4000 // in ms, while up-to-date (other notaries announce their list heads)
+#define announceListHeadsInterval 200 // in ms, only announced if new entries were found
+#define listHeadRefreshInterval 2000 // in ms, announced even without new entries
+#define publishNodeStatusInterval 100 // in ms
 
 #define signEntriesInterval 75 // in ms
 #define downloadNewEntriesInterval 600 // in ms
@@ -16,491 +18,657 @@
 #define updateServersInterval 5000 // in ms
 #define reportContactsInterval 20000 // in ms
 #define updateRenotarizationAttemptsInterval 15000 // in ms
+#define packSignatureListsInterval 50 // in ms
+#define persistExchangeOfferRatiosInterval 3000 // in ms
+#define saveCheckpointInterval 10000 // in ms
+#define growKeyFiltersInterval 5000 // in ms
+#define gatedTasksRetryInterval 100 // in ms, for tasks waiting for connection, up-to-date status or acting
 
 #define maxLoopRepetitionsAtOnce 1000000
+// per run of renotarizations and thread terminations, which then continue as soon as no other work has priority
+#define renotarizationBudgetRepetitions 1000
+#define renotarizationBudgetInMs 250
+#define renotarizationBatchSize 25 // entries claimed, signed and stored together
 
 InternalThread::InternalThread(Database *d, OtherServersHandler *s, MessageBuilder* m)
-    : db(d), servers(s), msgBuilder(m)
+    : db(d), servers(s), msgBuilder(m), activeWorkers(0), upToDate(false), reportUpToDateStatusNext(0),
+      pubKeyIsRegistered(false)
 {
     running=false;
-    stopped=true;
+    for (unsigned char listType=0; listType<5; listType++)
+    {
+        announcedHeads[listType] = CompleteID(0,0,0);
+        announcedAt[listType] = 0;
+    }
+    db->setScheduler(&scheduler);
 }
 
 void InternalThread::start()
 {
     running=true;
-    if(pthread_create(&thread, NULL, InternalThread::routine, (void*) this) < 0)
+    tNotaryNr = msgBuilder->getTNotaryNr();
+    for (int group=0; group<taskGroupsNum; group++)
     {
-        puts("InternalThread::routine: could not create internal thread");
-        running=false;
-        return;
+        workers[group].internal = this;
+        workers[group].group = (TaskGroup) group;
+        activeWorkers++;
+        if(pthread_create(&workers[group].thread, NULL, InternalThread::routine, (void*) &workers[group]) != 0)
+        {
+            puts("InternalThread::start: could not create worker thread");
+            activeWorkers--;
+            running=false;
+            scheduler.stop();
+            return;
+        }
+        pthread_detach(workers[group].thread);
     }
-    stopped=false;
-    pthread_detach(thread);
 }
 
 InternalThread::~InternalThread()
 {
+    db->setScheduler(nullptr);
+}
 
+void InternalThread::tasksReport()
+{
+    string msg("Internal thread tasks: ");
+    scheduler.report(msg);
+    puts(msg.c_str());
 }
 
-void* InternalThread::routine(void *internalThread)
+// each worker runs the tasks of one group
+void* InternalThread::routine(void *worker)
 {
-    InternalThread* internal=(InternalThread*) internalThread;
-    internal->stopped=false;
-    unsigned long long checkNewEntriesNext = 0;
-    unsigned long long downloadNewEntriesNext = 0;
-    unsigned long long updateServersNext = 0;
-    unsigned long long signEntriesNext = 0;
-    unsigned long long terminateThreadsNext = 0;
-    unsigned long long registerKeyNext = 0;
-    unsigned long long updateNotariesListNext = 0;
-    unsigned long long reportUpToDateStatusNext = 0;
-    unsigned long long checkUpToDateStatusNext = 0;
-    unsigned long long startRenotarizationsNext = 0;
-    unsigned long long reportContactsNext = 0;
-    unsigned long long updateRenotarizationAttemptsNext = 0;
-    bool upToDate = false;
-    TNtrNr tNotaryNr = internal->msgBuilder->getTNotaryNr(); // own number
-    CompleteID pubKeyId;
-    bool pubKeyIsRegistered = false;
-    bool amActing = false;
-    set<unsigned long>* notaries = nullptr;
+    InternalThread* internal=((Worker*) worker)->internal;
+    const TaskGroup group=((Worker*) worker)->group;
     unsigned long long currentTime;
     do
     {
-        usleep(routineSleepTimeInMcrS);
-        currentTime = internal->db->systemTimeInMs();
+        // sleep until the next task of the group is due or work is triggered
+        currentTime = internal->scheduler.waitForDueTask(group);
+        if (!internal->running) break;
 
-        // update ip, port etc. for servers
-        if (currentTime >= updateServersNext)
+        switch (group)
+        {
+        case groupStatus:
+            runStatusTasks(internal, currentTime);
+            break;
+        case groupSigning:
+            runSigningTasks(internal, currentTime);
+            break;
+        case groupSynchronization:
+            runSynchronizationTasks(internal, currentTime);
+            break;
+        case groupRenotarization:
+            runRenotarizationTasks(internal, currentTime);
+            break;
+        default:
+            runMaintenanceTasks(internal, currentTime);
+        }
+    }
+    while(internal->running);
+
+    if (--internal->activeWorkers == 0) puts("InternalThread::routine stopped");
+    return NULL;
+}
+
+void InternalThread::runSynchronizationTasks(InternalThread* internal, unsigned long long currentTime)
+{
+    Scheduler* scheduler = &internal->scheduler;
+
+    // sync recently committed writes (group commit)
+    if (scheduler->isDue(taskSyncWAL, currentTime))
+    {
+        scheduler->startRun(taskSyncWAL, currentTime);
+        if (currentTime >= internal->db->getNextWalSyncTime()) internal->db->syncWAL();
+        scheduler->finishRun(taskSyncWAL, internal->db->getNextWalSyncTime());
+    }
+
+    // check for missing entries
+    if (scheduler->isDue(taskCheckNewEntries, currentTime))
+    {
+        scheduler->startRun(taskCheckNewEntries, currentTime);
+        for (unsigned char listType=0; listType<5; listType++)
         {
             internal->db->lock();
-            internal->db->addContactsToServers(internal->servers, tNotaryNr.getNotaryNr());
+            CompleteID upToDateID = internal->db->getUpToDateID(listType);
             internal->db->unlock();
 
-            updateServersNext=currentTime+updateServersInterval;
+            internal->servers->checkNewerEntry(listType, upToDateID, 1, (listType==4));
         }
+        if (internal->upToDate) scheduler->finishRun(taskCheckNewEntries, currentTime+checkNewEntriesFallbackInterval);
+        else scheduler->finishRun(taskCheckNewEntries, currentTime+checkNewEntriesInterval);
+    }
+
+    // download missing entries (also triggered by new download targets)
+    if (scheduler->isDue(taskDownloadNewEntries, currentTime))
+    {
+        scheduler->startRun(taskDownloadNewEntries, currentTime);
+        // try to download something
+        internal->db->lock();
+        CompleteID entryID = internal->db->getNextEntryToDownload();
+        const unsigned long long nextRetryTime = internal->db->getNextDownloadRetryTime();
+        internal->db->unlock();
+
+        if (!entryID.isZero())
+        {
+            internal->servers->requestEntry(entryID, internal->servers->getSomeReachableNotary());
+        }
+
+        scheduler->finishRun(taskDownloadNewEntries, currentTime+downloadNewEntriesInterval);
+        // retries of earlier attempts are due
+        scheduler->scheduleAt(taskDownloadNewEntries, nextRetryTime);
+    }
 
-        // check for missing entries
-        if (currentTime >= checkNewEntriesNext)
+    // push new entries of own lists to other notaries (replacing most of their checks for new entries)
+    if (scheduler->isDue(taskAnnounceListHeads, currentTime))
+    {
+        scheduler->startRun(taskAnnounceListHeads, currentTime);
+        if (internal->upToDate && internal->tNotaryNr.isGood())
         {
             for (unsigned char listType=0; listType<5; listType++)
             {
+                CompleteID &head = internal->announcedHeads[listType];
+                CIDsSet newerIds;
                 internal->db->lock();
-                CompleteID upToDateID = internal->db->getUpToDateID(listType);
+                if (head.isZero()) head = internal->db->getUpToDateID(listType); // start with the own up-to-date id
+                bool success = internal->db->loadNewerEntriesIds(listType, head, newerIds);
                 internal->db->unlock();
-
-                internal->servers->checkNewerEntry(listType, upToDateID, 1, (listType==4));
+                if (!success || newerIds.size()>2 || newerIds.size()<1) continue;
+                CompleteID id1 = newerIds.first();
+                CompleteID id2 = newerIds.last();
+                // without new entries only after some time
+                if (id1.getNotary() <= 0 && currentTime < internal->announcedAt[listType] + listHeadRefreshInterval) continue;
+                internal->servers->sendListHeadToAll(listType, head, id1, id2);
+                head = id2;
+                internal->announcedAt[listType] = currentTime;
             }
-            checkNewEntriesNext=currentTime+checkNewEntriesInterval;
         }
+        scheduler->finishRun(taskAnnounceListHeads, currentTime+announceListHeadsInterval);
+    }
+}
 
-        // download missing entries
-        if (currentTime >= downloadNewEntriesNext)
-        {
-            // try to download something
-            internal->db->lock();
-            CompleteID entryID = internal->db->getNextEntryToDownload();
-            if (entryID.isZero()) entryID = internal->db->getNextEntryToDownload();
-            internal->db->unlock();
+void InternalThread::runStatusTasks(InternalThread* internal, unsigned long long currentTime)
+{
+    Scheduler* scheduler = &internal->scheduler;
 
-            if (!entryID.isZero())
-            {
-                internal->servers->requestEntry(entryID, internal->servers->getSomeReachableNotary());
-            }
+    // recompute the status read by request threads (also triggered by new up-to-date ids)
+    if (scheduler->isDue(taskPublishNodeStatus, currentTime))
+    {
+        scheduler->startRun(taskPublishNodeStatus, currentTime);
+        unsigned long long wellConnectedSince = internal->servers->getWellConnectedSince();
+        internal->db->lock();
+        internal->db->publishNodeStatus(wellConnectedSince);
+        internal->db->unlock();
+        scheduler->finishRun(taskPublishNodeStatus, currentTime+publishNodeStatusInterval);
+    }
+}
 
-            downloadNewEntriesNext=currentTime+downloadNewEntriesInterval;
-        }
+void InternalThread::runMaintenanceTasks(InternalThread* internal, unsigned long long currentTime)
+{
+    Scheduler* scheduler = &internal->scheduler;
+    const TNtrNr &tNotaryNr = internal->tNotaryNr;
 
-        // check db up-to-date status
-        if (currentTime >= checkUpToDateStatusNext)
-        {
-            unsigned long long wellConnectedSince = internal->servers->getWellConnectedSince();
-            internal->db->lock();
-            bool upToDateNew = internal->db->dbUpToDate(wellConnectedSince);
-            internal->db->unlock();
+    // convert old signature lists into the packed format
+    if (scheduler->isDue(taskPackSignatureLists, currentTime))
+    {
+        scheduler->startRun(taskPackSignatureLists, currentTime);
+        internal->db->lock();
+        const bool morePending = internal->db->packNextSignatureLists();
+        internal->db->unlock();
+        if (morePending) scheduler->finishRun(taskPackSignatureLists, currentTime+packSignatureListsInterval);
+        else scheduler->finishRun(taskPackSignatureLists, ULLONG_MAX);
+    }
+
+    // store exchange offer ratios updated by requests
+    if (scheduler->isDue(taskPersistExchangeOfferRatios, currentTime))
+    {
+        scheduler->startRun(taskPersistExchangeOfferRatios, currentTime);
+        internal->db->lock();
+        internal->db->persistExchangeOfferRatios();
+        internal->db->unlock();
+        scheduler->finishRun(taskPersistExchangeOfferRatios, currentTime+persistExchangeOfferRatiosInterval);
+    }
+
+    // update ip, port etc. for servers
+    if (scheduler->isDue(taskUpdateServers, currentTime))
+    {
+        scheduler->startRun(taskUpdateServers, currentTime);
+        internal->db->lock();
+        internal->db->addContactsToServers(internal->servers, tNotaryNr.getNotaryNr());
+        internal->db->unlock();
+
+        scheduler->finishRun(taskUpdateServers, currentTime+updateServersInterval);
+    }
+
+    // check db up-to-date status
+    if (scheduler->isDue(taskCheckUpToDateStatus, currentTime))
+    {
+        scheduler->startRun(taskCheckUpToDateStatus, currentTime);
+        unsigned long long wellConnectedSince = internal->servers->getWellConnectedSince();
+        internal->db->lock();
+        bool upToDateNew = internal->db->dbUpToDate(wellConnectedSince);
+        internal->db->unlock();
 
-            // report db up-to-date status
-            if (currentTime >= reportUpToDateStatusNext || (upToDateNew && !upToDate))
+        // report db up-to-date status
+        if (currentTime >= internal->reportUpToDateStatusNext || (upToDateNew && !internal->upToDate))
+        {
+            if (!upToDateNew)
             {
-                if (!upToDateNew)
-                {
-                    puts("Database not yet up-to-date. Current status:");
+                puts("Database not yet up-to-date. Current status:");
 
-                    Util u;
-                    string out;
+                Util u;
+                string out;
 
-                    if (wellConnectedSince > 0)
-                    {
-                        out = "wellConnectedSince: ";
-                        out.append(u.epochToStr(wellConnectedSince));
-                        puts(out.c_str());
-                    }
-                    else
-                    {
-                        puts("not well connected");
-                    }
+                if (wellConnectedSince > 0)
+                {
+                    out = "wellConnectedSince: ";
+                    out.append(u.epochToStr(wellConnectedSince));
+                    puts(out.c_str());
+                }
+                else
+                {
+                    puts("not well connected");
+                }
 
-                    // report which notaries this notary is connected to
-                    list<unsigned long> notariesList;
-                    internal->servers->loadContactsReachable(notariesList);
-                    if (notariesList.size()<=0)
-                    {
-                        puts("not connected to any notary");
-                    }
-                    else
+                // report which notaries this notary is connected to
+                list<unsigned long> notariesList;
+                internal->servers->loadContactsReachable(notariesList);
+                if (notariesList.size()<=0)
+                {
+                    puts("not connected to any notary");
+                }
+                else
+                {
+                    string txt("currently connected to notaries: ");
+                    list<unsigned long>::iterator it;
+                    for (it=notariesList.begin(); it!=notariesList.end(); ++it)
                     {
-                        string txt("currently connected to notaries: ");
-                        list<unsigned long>::iterator it;
-                        for (it=notariesList.begin(); it!=notariesList.end(); ++it)
-                        {
-                            if (it != notariesList.begin()) txt.append(", ");
-                            txt.append(to_string(*it));
-                        }
-                        puts(txt.c_str());
+                        if (it != notariesList.begin()) txt.append(", ");
+                        txt.append(to_string(*it));
                     }
+                    puts(txt.c_str());
+                }
 
-                    // report up-to-date-timestamps
-                    internal->db->lock();
-                    CompleteID upToDateID1 = internal->db->getUpToDateID(0);
-                    CompleteID upToDateID2 = internal->db->getUpToDateID(1);
-                    CompleteID upToDateID3 = internal->db->getUpToDateID(2);
-                    CompleteID upToDateID4 = internal->db->getUpToDateID(3);
-                    CompleteID upToDateID5 = internal->db->getUpToDateID(4);
-                    internal->db->unlock();
-
-                    out = "listEssentials up-to-date-timestamp: ";
-                    out.append(u.epochToStr(upToDateID1.getTimeStamp()));
-                    puts(out.c_str());
+                // report up-to-date-timestamps
+                internal->db->lock();
+                CompleteID upToDateID1 = internal->db->getUpToDateID(0);
+                CompleteID upToDateID2 = internal->db->getUpToDateID(1);
+                CompleteID upToDateID3 = internal->db->getUpToDateID(2);
+                CompleteID upToDateID4 = internal->db->getUpToDateID(3);
+                CompleteID upToDateID5 = internal->db->getUpToDateID(4);
+                internal->db->unlock();
 
-                    out = "listGeneral up-to-date-timestamp: ";
-                    out.append(u.epochToStr(upToDateID2.getTimeStamp()));
-                    puts(out.c_str());
+                out = "listEssentials up-to-date-timestamp: ";
+                out.append(u.epochToStr(upToDateID1.getTimeStamp()));
+                puts(out.c_str());
 
-                    out = "listTerminations up-to-date-timestamp: ";
-                    out.append(u.epochToStr(upToDateID3.getTimeStamp()));
-                    puts(out.c_str());
+                out = "listGeneral up-to-date-timestamp: ";
+                out.append(u.epochToStr(upToDateID2.getTimeStamp()));
+                puts(out.c_str());
 
-                    out = "listPerpetuals up-to-date-timestamp: ";
-                    out.append(u.epochToStr(upToDateID4.getTimeStamp()));
-                    puts(out.c_str());
+                out = "listTerminations up-to-date-timestamp: ";
+                out.append(u.epochToStr(upToDateID3.getTimeStamp()));
+                puts(out.c_str());
 
-                    out = "listTransfers up-to-date-timestamp: ";
-                    out.append(u.epochToStr(upToDateID5.getTimeStamp()));
-                    puts(out.c_str());
+                out = "listPerpetuals up-to-date-timestamp: ";
+                out.append(u.epochToStr(upToDateID4.getTimeStamp()));
+                puts(out.c_str());
 
-                    out = "Downloading ";
-                    internal->db->lock();
-                    size_t nrToDownload = internal->db->getEntriesInDownload();
-                    out.append(to_string(nrToDownload));
-                    internal->db->unlock();
-                    if (nrToDownload == 1) out.append(" entry.");
-                    else out.append(" entries.");
-                    puts(out.c_str());
+                out = "listTransfers up-to-date-timestamp: ";
+                out.append(u.epochToStr(upToDateID5.getTimeStamp()));
+                puts(out.c_str());
 
-                    puts("Please wait ...");
-                }
-                else if (!upToDate) puts("Database now up-to-date.");
+                out = "Downloading ";
+                internal->db->lock();
+                size_t nrToDownload = internal->db->getEntriesInDownload();
+                out.append(to_string(nrToDownload));
+                internal->db->unlock();
+                if (nrToDownload == 1) out.append(" entry.");
+                else out.append(" entries.");
+                puts(out.c_str());
 
-                reportUpToDateStatusNext=currentTime+reportUpToDateStatusInterval;
+                puts("Please wait ...");
             }
+            else if (!internal->upToDate) puts("Database now up-to-date.");
 
-            upToDate=upToDateNew;
-            checkUpToDateStatusNext=currentTime+checkUpToDateStatusInterval;
+            internal->reportUpToDateStatusNext=currentTime+reportUpToDateStatusInterval;
         }
 
-        // rebuild corresponding notaries list
-        currentTime = internal->db->systemTimeInMs();
-        if (currentTime >= updateNotariesListNext)
-        {
-            // delete notaries list
-            if (notaries!=nullptr)
-            {
-                notaries->clear();
-                delete notaries;
-            }
+        internal->upToDate=upToDateNew;
+        scheduler->finishRun(taskCheckUpToDateStatus, currentTime+checkUpToDateStatusInterval);
+    }
 
-            // get acting notaries
-            internal->db->lock();
-            amActing = internal->db->isActingNotary(tNotaryNr, currentTime);
-            set<unsigned long>* actingNotaries = internal->db->getActingNotaries(currentTime);
-            internal->db->unlock();
+    // rebuild corresponding notaries list
+    currentTime = internal->db->systemTimeInMs();
+    shared_ptr<set<unsigned long>> notaries = atomic_load(&internal->notaries);
+    if (notaries == nullptr || scheduler->isDue(taskUpdateNotariesList, currentTime))
+    {
+        scheduler->startRun(taskUpdateNotariesList, currentTime);
+
+        // get acting notaries
+        bool amActing = internal->db->isActingNotary(tNotaryNr, currentTime);
+        set<unsigned long>* actingNotaries = internal->db->getActingNotaries(currentTime);
+
+        // generate relevant notaries list, replacing the one used by other workers
+        if (amActing) actingNotaries->erase(tNotaryNr.getNotaryNr());
+        notaries = shared_ptr<set<unsigned long>>(internal->servers->genNotariesList(*actingNotaries));
+        atomic_store(&internal->notaries, notaries);
 
-            // generate relevant notaries list
-            if (amActing) actingNotaries->erase(tNotaryNr.getNotaryNr());
-            notaries = internal->servers->genNotariesList(*actingNotaries);
+        actingNotaries->clear();
+        delete actingNotaries;
 
-            actingNotaries->clear();
-            delete actingNotaries;
+        scheduler->finishRun(taskUpdateNotariesList, currentTime + updateNotariesListInterval);
+    }
 
-            updateNotariesListNext = currentTime + updateNotariesListInterval;
+    // report contacts
+    if (scheduler->isDue(taskReportContacts, currentTime))
+    {
+        scheduler->startRun(taskReportContacts, currentTime);
+        // load contacts from db
+        list<string> contacts;
+        internal->db->lock();
+        bool result = internal->db->loadContactsList(notaries.get(), contacts);
+        ContactInfo* contactInfo = internal->db->getContactInfo(tNotaryNr);
+        internal->db->unlock();
+
+        // add own contact info
+        if (result && contactInfo!=nullptr)
+        {
+            contacts.push_back(*contactInfo->getByteSeq());
         }
+        if (contactInfo!=nullptr) delete contactInfo;
 
-        // report contacts
-        if (currentTime >= reportContactsNext)
+        // send
+        if (result)
         {
-            // load contacts from db
-            list<string> contacts;
-            internal->db->lock();
-            bool result = internal->db->loadContactsList(notaries, contacts);
-            ContactInfo* contactInfo = internal->db->getContactInfo(tNotaryNr);
-            internal->db->unlock();
+            internal->servers->sendContactsList(contacts, *notaries);
+        }
 
-            // add own contact info
-            if (result && contactInfo!=nullptr)
-            {
-                contacts.push_back(*contactInfo->getByteSeq());
-            }
-            if (contactInfo!=nullptr) delete contactInfo;
+        // request contact infos for yourself
+        internal->servers->sendContactsRqst();
 
-            // send
-            if (result)
-            {
-                internal->servers->sendContactsList(contacts, *notaries);
-            }
+        scheduler->finishRun(taskReportContacts, currentTime+reportContactsInterval);
+    }
 
-            // request contact infos for yourself
-            internal->servers->sendContactsRqst();
+    // store entries to sign, entries to download and up-to-date ids for a warm start
+    if (scheduler->isDue(taskSaveCheckpoint, currentTime))
+    {
+        scheduler->startRun(taskSaveCheckpoint, currentTime);
+        internal->db->lock();
+        internal->db->saveCheckpoint();
+        internal->db->unlock();
+        scheduler->finishRun(taskSaveCheckpoint, currentTime+saveCheckpointInterval);
+    }
 
-            reportContactsNext=currentTime+reportContactsInterval;
-        }
+    // add capacity to key filters which received more keys than they were sized for
+    if (scheduler->isDue(taskGrowKeyFilters, currentTime))
+    {
+        scheduler->startRun(taskGrowKeyFilters, currentTime);
+        internal->db->growKeyFilters();
+        scheduler->finishRun(taskGrowKeyFilters, currentTime+growKeyFiltersInterval);
+    }
+}
+
+// true if the server is well-connected, up-to-date and acting, otherwise the tasks of the group are postponed
+bool InternalThread::readyForGatedTasks(InternalThread* internal, TaskGroup group, unsigned long long currentTime)
+{
+    shared_ptr<set<unsigned long>> notaries = atomic_load(&internal->notaries);
+    bool ready = (notaries != nullptr && internal->upToDate && internal->servers->wellConnected(notaries->size()));
+    if (ready) ready = internal->db->isActingNotaryWithBuffer(internal->tNotaryNr, currentTime);
+    if (!ready) internal->scheduler.postponeGroup(group, currentTime+gatedTasksRetryInterval);
+    return ready;
+}
 
-        // check that server is well-connected and up-to-date
-        if (!internal->servers->wellConnected(notaries->size()) || !upToDate) continue;
+void InternalThread::runSigningTasks(InternalThread* internal, unsigned long long currentTime)
+{
+    Scheduler* scheduler = &internal->scheduler;
+    if (!readyForGatedTasks(internal, groupSigning, currentTime)) return;
 
-        // check if amActing and if any threads terminated
+    // check if any threads terminated (scheduled for the next termination time)
+    if (scheduler->isDue(taskCheckThreadTerminations, currentTime))
+    {
+        scheduler->startRun(taskCheckThreadTerminations, currentTime);
         internal->db->lock();
-        amActing = internal->db->isActingNotaryWithBuffer(tNotaryNr, currentTime);
-        if (amActing) internal->db->checkThreadTerminations();
+        internal->db->checkThreadTerminations();
+        const unsigned long long nextTerminationTime = internal->db->getNextTerminationTime();
         internal->db->unlock();
+        scheduler->finishRun(taskCheckThreadTerminations, nextTerminationTime);
+    }
 
-        if (!amActing) continue;
-
-        // sign outstanding entries
-        if (currentTime >= signEntriesNext)
+    // sign outstanding entries (immediately if a signature is due)
+    if (scheduler->isDue(taskSignEntries, currentTime))
+    {
+        scheduler->startRun(taskSignEntries, currentTime);
+        string type13entryStr;
+        string type12entryStr;
+        CompleteID zeroId;
+        unsigned long c = 0;
+        while (internal->servers->wellConnected() && c<maxLoopRepetitionsAtOnce)
         {
-            string type13entryStr;
-            string type12entryStr;
-            CompleteID zeroId;
-            unsigned long c = 0;
-            while (internal->servers->wellConnected() && c<maxLoopRepetitionsAtOnce)
+            internal->db->lock();
+            if (!internal->db->loadNextEntryToSign(type13entryStr, type12entryStr))
             {
-                internal->db->lock();
-                if (!internal->db->loadNextEntryToSign(type13entryStr, type12entryStr))
-                {
-                    internal->db->unlock();
-                    break;
-                }
-                else c++;
                 internal->db->unlock();
-
-                Type13Entry *entry = new Type13Entry(type13entryStr);
-                Type12Entry *uEntry = new Type12Entry(type12entryStr);
-                Type13Entry *signedEntry = internal->msgBuilder->signEntry(entry, uEntry, zeroId);
-                if (signedEntry!=nullptr)
-                {
-                    internal->servers->sendSignatureToAll(signedEntry->getByteSeq());
-                    // clean up
-                    delete signedEntry;
-                }
-                delete entry;
-                delete uEntry;
-                type13entryStr = "";
-                type12entryStr = "";
+                break;
             }
-            signEntriesNext=currentTime+signEntriesInterval;
-        }
-
-        // update renotarization attempts
-        if (currentTime >= updateRenotarizationAttemptsNext)
-        {
-            internal->db->lock();
-            internal->db->updateRenotarizationAttempts();
+            else c++;
             internal->db->unlock();
-            updateRenotarizationAttemptsNext=currentTime+updateRenotarizationAttemptsInterval;
-        }
 
-        // start renotarizations
-        if (currentTime >= startRenotarizationsNext)
-        {
-            CompleteID entryId;
-            unsigned long c = 0;
-            while (internal->servers->wellConnected() && c<maxLoopRepetitionsAtOnce)
+            Type13Entry *entry = new Type13Entry(type13entryStr);
+            Type12Entry *uEntry = new Type12Entry(type12entryStr);
+            Type13Entry *signedEntry = internal->msgBuilder->signEntry(entry, uEntry, zeroId);
+            if (signedEntry!=nullptr)
             {
-                internal->db->lock();
+                internal->servers->sendSignatureToAll(signedEntry->getByteSeq());
+                // clean up
+                delete signedEntry;
+            }
+            delete entry;
+            delete uEntry;
+            type13entryStr = "";
+            type12entryStr = "";
+        }
+        scheduler->finishRun(taskSignEntries, currentTime+signEntriesInterval);
+        // entries added in the meantime
+        scheduler->scheduleAt(taskSignEntries, internal->db->getNextSigningTime());
+    }
+}
 
-                int attemptStatus = internal->db->loadNextEntryToRenotarize(entryId);
+// signed entries are added with one write, only those added are sent
+void InternalThread::storeAndSendSignatures(InternalThread* internal, list<Type13Entry*> &signedEntries, set<unsigned long> &notaries)
+{
+    if (signedEntries.empty()) return;
+    internal->db->lock();
+    internal->db->addType13Entries(signedEntries);
+    internal->db->unlock();
 
-                if (attemptStatus == -1)
-                {
-                    internal->db->unlock();
-                    break;
-                }
-                else c++;
+    list<Type13Entry*>::iterator it;
+    for (it=signedEntries.begin(); it!=signedEntries.end(); ++it)
+    {
+        internal->servers->sendNewSignature(*it, notaries);
+        delete *it;
+    }
+    signedEntries.clear();
+}
 
-                if (attemptStatus == 0)
-                {
-                    internal->db->unlock();
-                    continue;
-                }
+// renotarizations and thread terminations give way to signing etc. after their budget
+bool InternalThread::budgetUsedUp(InternalThread* internal, unsigned long repetitions, unsigned long long runStart)
+{
+    if (repetitions >= renotarizationBudgetRepetitions) return true;
+    if (Scheduler::systemTimeInMs() >= runStart + renotarizationBudgetInMs) return true;
+    return internal->scheduler.preempted(groupRenotarization);
+}
 
-                string t13eStr;
-                if (!internal->db->loadType13EntryStr(entryId, 0, t13eStr))
-                {
-                    internal->db->unlock();
-                    continue;
-                }
-                Type13Entry t13e(t13eStr);
-                CompleteID entryIdFirst = internal->db->getFirstID(entryId);
-                string t13eFirstStr;
-                if (!internal->db->loadType13EntryStr(entryIdFirst, 0, t13eFirstStr))
-                {
-                    internal->db->unlock();
-                    continue;
-                }
-                Type12Entry *t12e = internal->db->createT12FromT13Str(t13eFirstStr);
+void InternalThread::runRenotarizationTasks(InternalThread* internal, unsigned long long currentTime)
+{
+    Scheduler* scheduler = &internal->scheduler;
+    const TNtrNr &tNotaryNr = internal->tNotaryNr;
+    if (!readyForGatedTasks(internal, groupRenotarization, currentTime)) return;
+    shared_ptr<set<unsigned long>> notaries = atomic_load(&internal->notaries);
 
-                internal->db->unlock();
+    // update renotarization attempts
+    if (scheduler->isDue(taskUpdateRenotarizationAttempts, currentTime))
+    {
+        scheduler->startRun(taskUpdateRenotarizationAttempts, currentTime);
+        internal->db->lock();
+        internal->db->updateRenotarizationAttempts();
+        internal->db->unlock();
+        scheduler->finishRun(taskUpdateRenotarizationAttempts, currentTime+updateRenotarizationAttemptsInterval);
+    }
 
-                if (t12e == nullptr)
-                {
-                    continue;
-                }
+    // start renotarizations
+    if (scheduler->isDue(taskStartRenotarizations, currentTime))
+    {
+        scheduler->startRun(taskStartRenotarizations, currentTime);
+        const unsigned long long runStart = Scheduler::systemTimeInMs();
+        unsigned long c = 0;
+        bool budgetUsed = false;
+        while (internal->servers->wellConnected())
+        {
+            if (budgetUsedUp(internal, c, runStart))
+            {
+                budgetUsed = true;
+                break;
+            }
+            // claim a batch of due entries together with their data
+            list<Database::RenotarizationJob> jobs;
+            internal->db->lock();
+            const size_t claimed = internal->db->loadNextEntriesToRenotarize(renotarizationBatchSize, jobs);
+            internal->db->unlock();
+            c += claimed;
 
-                // create signature
-                Type13Entry* signedEntry = internal->msgBuilder->signEntry(&t13e, t12e, entryId);
-                if (signedEntry == nullptr)
-                {
-                    delete t12e;
-                    continue;
-                }
+            // create signatures without holding the lock
+            list<Type13Entry*> signedEntries;
+            list<Database::RenotarizationJob>::iterator it;
+            for (it=jobs.begin(); it!=jobs.end(); ++it)
+            {
+                Type13Entry t13e(it->t13eStr);
+                Type13Entry* signedEntry = internal->msgBuilder->signEntry(&t13e, it->t12e, it->entryId);
+                if (signedEntry != nullptr) signedEntries.push_back(signedEntry);
+                delete it->t12e;
+            }
 
-                // store and send
-                internal->db->lock();
-                bool result = internal->db->addType13Entry(signedEntry, false);
-                internal->db->unlock();
+            // store all at once and send
+            storeAndSendSignatures(internal, signedEntries, *notaries);
+            if (claimed < renotarizationBatchSize) break;
+        }
+        // continue as soon as no other work has priority
+        if (budgetUsed) scheduler->finishRun(taskStartRenotarizations, Scheduler::systemTimeInMs());
+        else scheduler->finishRun(taskStartRenotarizations, currentTime+startRenotarizationsInterval);
+    }
 
-                if (result)
-                {
-                    internal->servers->sendNewSignature(signedEntry, *notaries);
-                }
+    internal->pubKeyIsRegistered = internal->pubKeyIsRegistered && internal->db->isFreshNow(internal->pubKeyId);
+    internal->db->lock();
+    internal->pubKeyIsRegistered = internal->pubKeyIsRegistered && (internal->pubKeyId == internal->db->getLatestNotaryId(tNotaryNr));
+    internal->db->unlock();
 
-                delete signedEntry;
-                delete t12e;
+    // check for new type 9 entries to be created
+    if (!internal->pubKeyIsRegistered) scheduler->postpone(taskTerminateThreads, currentTime+registerKeyInterval);
+    else if (scheduler->isDue(taskTerminateThreads, currentTime))
+    {
+        scheduler->startRun(taskTerminateThreads, currentTime);
+        const unsigned long long runStart = Scheduler::systemTimeInMs();
+        unsigned long c = 0;
+        bool budgetUsed = false;
+        while (internal->servers->wellConnected())
+        {
+            if (budgetUsedUp(internal, c, runStart))
+            {
+                budgetUsed = true;
+                break;
             }
-            startRenotarizationsNext=currentTime+startRenotarizationsInterval;
-        }
+            // claim a batch of due thread terminations
+            list<CompleteID> threadIds;
+            internal->db->lock();
+            const size_t claimed = internal->db->loadNextTerminatingThreads(renotarizationBatchSize, threadIds);
+            internal->db->unlock();
+            c += claimed;
 
-        pubKeyIsRegistered = pubKeyIsRegistered && internal->db->isFreshNow(pubKeyId);
-        internal->db->lock();
-        pubKeyIsRegistered = pubKeyIsRegistered && (pubKeyId == internal->db->getLatestNotaryId(tNotaryNr));
-        internal->db->unlock();
+            // create signatures without holding the lock
+            list<Type13Entry*> signedEntries;
+            list<CompleteID>::iterator it;
+            for (it=threadIds.begin(); it!=threadIds.end(); ++it)
+            {
+                Type13Entry* signedEntry = internal->msgBuilder->terminateAndSign(*it);
+                if (signedEntry != nullptr) signedEntries.push_back(signedEntry);
+            }
+
+            // store all at once and send
+            storeAndSendSignatures(internal, signedEntries, *notaries);
+            if (claimed < renotarizationBatchSize) break;
+        }
+        // continue as soon as no other work has priority
+        if (budgetUsed) scheduler->finishRun(taskTerminateThreads, Scheduler::systemTimeInMs());
+        else scheduler->finishRun(taskTerminateThreads, currentTime+terminateThreadsInterval);
+    }
 
-        // check for new type 9 entries to be created
-        if (pubKeyIsRegistered && currentTime >= terminateThreadsNext)
+    // register own public key
+    if (tNotaryNr.isGood() && !internal->pubKeyIsRegistered)
+    {
+        if (scheduler->isDue(taskRegisterKey, currentTime))
         {
-            CompleteID threadId;
-            unsigned long c = 0;
-            while (internal->servers->wellConnected() && c<maxLoopRepetitionsAtOnce)
-            {
-                internal->db->lock();
-                if (!internal->db->loadNextTerminatingThread(threadId))
-                {
-                    internal->db->unlock();
-                    break;
-                }
-                else c++;
-                internal->db->unlock();
+            scheduler->startRun(taskRegisterKey, currentTime);
+            internal->db->lock();
+            internal->pubKeyId = internal->db->getLatestNotaryId(tNotaryNr);
+            internal->db->unlock();
 
-                Type13Entry* signedEntry = internal->msgBuilder->terminateAndSign(threadId);
-                if (signedEntry == nullptr)
+            if (internal->pubKeyId.getNotary() > 0)
+            {
+                if (internal->db->isFreshNow(internal->pubKeyId))
                 {
-                    continue;
+                    internal->msgBuilder->setPublicKeyId(internal->pubKeyId);
+                    internal->pubKeyIsRegistered=true;
                 }
-
-                internal->db->lock();
-                bool result = internal->db->addType13Entry(signedEntry, false);
-                internal->db->unlock();
-
-                if (result)
+                else
                 {
-                    internal->servers->sendNewSignature(signedEntry, *notaries);
+                    puts("InternalThread::routine: own notary public registered but not fresh");
                 }
-                delete signedEntry;
             }
-            terminateThreadsNext=currentTime+terminateThreadsInterval;
-        }
-
-        // register own public key
-        if (tNotaryNr.isGood() && !pubKeyIsRegistered)
-        {
-            if (currentTime >= registerKeyNext)
+            else
             {
+                puts("InternalThread::routine: attempting to register own notary public key in the database");
+                string str;
                 internal->db->lock();
-                pubKeyId = internal->db->getLatestNotaryId(tNotaryNr);
+                const bool loaded = internal->db->loadNotaryPubKey(tNotaryNr, str);
                 internal->db->unlock();
-
-                if (pubKeyId.getNotary() > 0)
+                if (loaded)
                 {
-                    if (internal->db->isFreshNow(pubKeyId))
-                    {
-                        internal->msgBuilder->setPublicKeyId(pubKeyId);
-                        pubKeyIsRegistered=true;
-                    }
-                    else
+                    Type13Entry* signedEntry = internal->msgBuilder->packKeyAndSign(str);
+                    if (signedEntry != nullptr)
                     {
-                        puts("InternalThread::routine: own notary public registered but not fresh");
-                    }
-                }
-                else
-                {
-                    puts("InternalThread::routine: attempting to register own notary public key in the database");
-                    string str;
-                    internal->db->lock();
-                    const bool loaded = internal->db->loadNotaryPubKey(tNotaryNr, str);
-                    internal->db->unlock();
-                    if (loaded)
-                    {
-                        Type13Entry* signedEntry = internal->msgBuilder->packKeyAndSign(str);
-                        if (signedEntry != nullptr)
+                        internal->db->lock();
+                        if (!internal->db->addType13Entry(signedEntry, false))
                         {
-                            internal->db->lock();
-                            if (!internal->db->addType13Entry(signedEntry, false))
-                            {
-                                internal->db->unlock();
-                                puts("InternalThread::routine: (own key registration) could not add signed entry to db");
-                            }
-                            else
-                            {
-                                internal->db->unlock();
-                                internal->servers->sendNewSignature(signedEntry, *notaries);
-                            }
-                            delete signedEntry;
+                            internal->db->unlock();
+                            puts("InternalThread::routine: (own key registration) could not add signed entry to db");
                         }
                         else
                         {
-                            puts("InternalThread::routine: could not create signedEntry");
+                            internal->db->unlock();
+                            internal->servers->sendNewSignature(signedEntry, *notaries);
                         }
+                        delete signedEntry;
                     }
                     else
                     {
-                        puts("InternalThread::routine: could not load own notary public key from db");
+                        puts("InternalThread::routine: could not create signedEntry");
                     }
                 }
-                registerKeyNext=currentTime+registerKeyInterval;
+                else
+                {
+                    puts("InternalThread::routine: could not load own notary public key from db");
+                }
             }
+            scheduler->finishRun(taskRegisterKey, currentTime+registerKeyInterval);
         }
     }
-    while(internal->running);
-
-    internal->stopped=true;
-    puts("InternalThread::routine stopped");
-    return NULL;
+    else scheduler->postpone(taskRegisterKey, currentTime+registerKeyInterval);
 }
 
 void InternalThread::stopSafely()
 {
     running=false;
-    while (!stopped) sleep(1);
+    scheduler.stop();
+    while (activeWorkers > 0) sleep(1);
 }
@@ -0,0 +1,144 @@
+#include "KeyFilter.h"
+
+KeyFilter::KeyFilter(const string &pref, const string &suff, size_t expectedKeys)
+    : prefix(pref), suffix(suff), stagesNum(0), keysAdded(0), queries(0), negatives(0), falsePositives(0)
+{
+    if (expectedKeys < keyFilterMinKeys) expectedKeys = keyFilterMinKeys;
+    stages[0] = newStage(expectedKeys);
+    stagesNum = 1;
+}
+
+KeyFilter::~KeyFilter()
+{
+    for (size_t i=0; i<stagesNum; i++) delete stages[i];
+}
+
+KeyFilter::Stage* KeyFilter::newStage(unsigned long long capacity)
+{
+    Stage* stage = new Stage();
+    size_t wordsNum = (capacity * keyFilterBitsPerKey + 63) / 64;
+    stage->bitsNum = wordsNum * 64;
+    stage->capacity = capacity;
+    stage->bits.reset(new atomic<unsigned long long>[wordsNum]);
+    for (size_t i=0; i<wordsNum; i++) stage->bits[i].store(0, memory_order_relaxed);
+    stage->keysAdded = 0;
+    return stage;
+}
+
+bool KeyFilter::covers(const rocksdb::Slice &key)
+{
+    if (key.size() < prefix.length() + suffix.length()) return false;
+    if (prefix.compare(0, prefix.length(), key.data(), prefix.length()) != 0) return false;
+    return (suffix.compare(0, suffix.length(), key.data() + key.size() - suffix.length(), suffix.length()) == 0);
+}
+
+// FNV-1a in two variants, combined by double hashing
+void KeyFilter::getHashes(const char* data, size_t length, unsigned long long &h1, unsigned long long &h2)
+{
+    h1 = 14695981039346656037ULL;
+    h2 = 0x9E3779B97F4A7C15ULL;
+    for (size_t i=0; i<length; i++)
+    {
+        h1 = (h1 ^ (unsigned char) data[i]) * 1099511628211ULL;
+        h2 = (h2 ^ (unsigned char) data[i]) * 0xFF51AFD7ED558CCDULL;
+    }
+    h2 |= 1;
+}
+
+void KeyFilter::add(const rocksdb::Slice &key)
+{
+    Stage* stage = stages[stagesNum-1];
+    unsigned long long h1, h2;
+    getHashes(key.data(), key.size(), h1, h2);
+    for (unsigned int i=0; i<keyFilterHashesNum; i++)
+    {
+        size_t bit = (h1 + i * h2) % stage->bitsNum;
+        stage->bits[bit / 64].fetch_or(1ULL << (bit % 64), memory_order_relaxed);
+    }
+    stage->keysAdded++;
+    keysAdded++;
+}
+
+// true if any stage might contain the key
+bool KeyFilter::mayContain(const rocksdb::Slice &key)
+{
+    queries++;
+    unsigned long long h1, h2;
+    getHashes(key.data(), key.size(), h1, h2);
+    const size_t stagesAvailable = stagesNum;
+    for (size_t s=0; s<stagesAvailable; s++)
+    {
+        Stage* stage = stages[s];
+        bool found = true;
+        for (unsigned int i=0; i<keyFilterHashesNum && found; i++)
+        {
+            size_t bit = (h1 + i * h2) % stage->bitsNum;
+            found = ((stage->bits[bit / 64].load(memory_order_relaxed) & (1ULL << (bit % 64))) != 0);
+        }
+        if (found) return true;
+    }
+    negatives++;
+    return false;
+}
+
+// to be called if mayContain was true but the key was not found
+void KeyFilter::falsePositive()
+{
+    falsePositives++;
+}
+
+// more keys were added to the latest stage than it was sized for (and another stage can be added)
+bool KeyFilter::isFull()
+{
+    const size_t n = stagesNum;
+    if (n >= keyFilterMaxStages) return false;
+    Stage* stage = stages[n-1];
+    return (stage->keysAdded > stage->capacity);
+}
+
+// false if the maximum number of stages is reached, not to be called by several threads at once
+bool KeyFilter::grow()
+{
+    const size_t n = stagesNum;
+    if (n >= keyFilterMaxStages) return false;
+    stages[n] = newStage(stages[n-1]->capacity * 2);
+    stagesNum = n+1;
+    return true;
+}
+
+unsigned long long KeyFilter::getCapacity()
+{
+    unsigned long long capacity = 0;
+    const size_t n = stagesNum;
+    for (size_t s=0; s<n; s++) capacity += stages[s]->capacity;
+    return capacity;
+}
+
+void KeyFilter::report(string &msg)
+{
+    const unsigned long long q = queries;
+    const unsigned long long n = negatives;
+    const unsigned long long fp = falsePositives;
+    msg.append("keys added: ");
+    msg.append(to_string(keysAdded));
+    const size_t stagesAvailable = stagesNum;
+    size_t bytesNum = 0;
+    for (size_t s=0; s<stagesAvailable; s++) bytesNum += stages[s]->bitsNum / 8;
+    msg.append(" (capacity: ");
+    msg.append(to_string(getCapacity()));
+    msg.append(", stages: ");
+    msg.append(to_string(stagesAvailable));
+    msg.append(", size in bytes: ");
+    msg.append(to_string(bytesNum));
+    msg.append("), queries: ");
+    msg.append(to_string(q));
+    msg.append(", filtered: ");
+    msg.append(to_string(n));
+    msg.append(", false positives: ");
+    msg.append(to_string(fp));
+    if (n + fp > 0)
+    {
+        msg.append(", false positive rate: ");
+        msg.append(to_string((double) fp / (n + fp)));
+    }
+}
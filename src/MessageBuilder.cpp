@@ -2,6 +2,9 @@
 #include "Database.h"
 #include "OtherServersHandler.h"
 
+#define signedResponsesCacheSize 512
+#define signedResponseMaxAgeInMs 600000
+
 MessageBuilder::MessageBuilder(TNtrNr notary, CryptoPP::RSA::PrivateKey *key)
     : notaryNr(notary), privateKey(key), publicKeyID(CompleteID()), db(nullptr), servers(nullptr), runningID(1)
 {
@@ -24,6 +27,10 @@ MessageBuilder::~MessageBuilder()
         delete rng;
         delete signer;
     }
+    responses_mutex.lock();
+    signedResponsesByKey.clear();
+    signedResponses.clear();
+    responses_mutex.unlock();
 }
 
 void MessageBuilder::setDB(Database *d)
@@ -59,7 +66,9 @@ string* MessageBuilder::signString(string &strToSign)
 {
     size_t length = signer->MaxSignatureLength();
     CryptoPP::SecByteBlock signature(length);
+    signer_mutex.lock();
     length = signer->SignMessage(*rng, (const byte*) strToSign.c_str(), strToSign.length(), signature);
+    signer_mutex.unlock();
     signature.resize(length);
     string* out = new string();
     out->append((const char*) signature.BytePtr(), signature.size());
@@ -86,17 +95,16 @@ bool MessageBuilder::appendConfirmation(list<Type13Entry*> &signaturesList, Type
 Type13Entry* MessageBuilder::signEntry(Type13Entry* entry, Type12Entry* uEntry, CompleteID &notPredecessorID)
 {
     if (db==nullptr || servers==nullptr || !notaryNr.isGood()) return nullptr;
-    unsigned long long wellConnectedSince = servers->getWellConnectedSince();
-    db->lock();
-    bool dbUpToDate = db->dbUpToDate(wellConnectedSince) && db->amCurrentlyActingWithBuffer();
+    if (!db->amActingAndUpToDate()) return nullptr;
     bool isConflicting = false;
     if (entry!=nullptr)
     {
         CompleteID firstID = entry->getFirstID();
+        db->lock();
         isConflicting = db->isConflicting(firstID);
+        db->unlock();
     }
-    db->unlock();
-    if (!dbUpToDate || isConflicting) return nullptr;
+    if (isConflicting) return nullptr;
 
     string cIDStr = newCompleteIDStr();
     return signEntry(entry, uEntry, notPredecessorID, cIDStr);
@@ -128,7 +136,9 @@ Type13Entry* MessageBuilder::signEntry(Type13Entry* entry, Type12Entry* uEntry,
         // sign string
         size_t length = signer->MaxSignatureLength();
         CryptoPP::SecByteBlock signature(length);
+        signer_mutex.lock();
         length = signer->SignMessage(*rng, (const byte*) strToSign.c_str(), strToSign.length(), signature);
+        signer_mutex.unlock();
         signature.resize(length);
         // finish type13entryStr
         unsigned long long uLength = uEntry->getByteSeq()->length();
@@ -161,7 +171,9 @@ Type13Entry* MessageBuilder::signEntry(Type13Entry* entry, Type12Entry* uEntry,
         // sign string
         size_t length = signer->MaxSignatureLength();
         CryptoPP::SecByteBlock signature(length);
+        signer_mutex.lock();
         length = signer->SignMessage(*rng, (const byte*) strToSign.c_str(), strToSign.length(), signature);
+        signer_mutex.unlock();
         signature.resize(length);
         // finish type13entryStr
         type13entryStr.append(u.UllAsByteSeq(signature.size()));
@@ -183,8 +195,7 @@ string MessageBuilder::newCompleteIDStr()
     string out;
     out.append(u.flip(u.UllAsByteSeq(systemTimeInMs())));
     out.append(u.flip(u.UlAsByteSeq(notaryNr.getNotaryNr())));
-    out.append(u.flip(u.UllAsByteSeq(runningID)));
-    runningID++;
+    out.append(u.flip(u.UllAsByteSeq(runningID.fetch_add(1))));
     return out;
 }
 
@@ -221,7 +232,9 @@ Type13Entry* MessageBuilder::signEntry(Entry* entry)
     // sign string
     size_t length = signer->MaxSignatureLength();
     CryptoPP::SecByteBlock signature(length);
+    signer_mutex.lock();
     length = signer->SignMessage(*rng, (const byte*) strToSign.c_str(), strToSign.length(), signature);
+    signer_mutex.unlock();
     signature.resize(length);
     // finish type12entryStr
     type12entryStr.append(strToSign);
@@ -262,7 +275,9 @@ Type13Entry* MessageBuilder::terminateAndSign(CompleteID &threadId)
     // sign string
     size_t length = signer->MaxSignatureLength();
     CryptoPP::SecByteBlock signature(length);
+    signer_mutex.lock();
     length = signer->SignMessage(*rng, (const byte*) strToSign.c_str(), strToSign.length(), signature);
+    signer_mutex.unlock();
     signature.resize(length);
     // finish type12entryStr
     type12entryStr.append(strToSign);
@@ -322,6 +337,23 @@ void MessageBuilder::sendPblcKeyInfo(list<Type13Entry*> &t13eList, int sock)
     }
 }
 
+// t13eListStr as built by addToString
+void MessageBuilder::sendPblcKeyInfo(string &t13eListStr, int sock)
+{
+    const char type = (char) 254;
+    vector<struct iovec> parts;
+    addPart(parts, &type, 1);
+    addPart(parts, t13eListStr.data(), t13eListStr.length());
+    if (sendPacked(parts, sock))
+    {
+        //puts("MessageBuilder::PblcKeyInfo sent successfully");
+    }
+    else
+    {
+        //puts("MessageBuilder::sendPblcKeyInfo unsuccessful");
+    }
+}
+
 bool MessageBuilder::addToString(list<string> &source, string &target)
 {
     Util u;
@@ -383,6 +415,23 @@ void MessageBuilder::sendCurrOrOblInfo(list<Type13Entry*> &t13eList, int sock)
     }
 }
 
+// t13eListStr as built by addToString
+void MessageBuilder::sendCurrOrOblInfo(string &t13eListStr, int sock)
+{
+    const char type = (char) 253;
+    vector<struct iovec> parts;
+    addPart(parts, &type, 1);
+    addPart(parts, t13eListStr.data(), t13eListStr.length());
+    if (sendPacked(parts, sock))
+    {
+        //puts("MessageBuilder::CurrOrOblInfo sent successfully");
+    }
+    else
+    {
+        //puts("MessageBuilder::sendCurrOrOblInfo unsuccessful");
+    }
+}
+
 void MessageBuilder::sendIdInfo(CompleteID &id, list<list<Type13Entry*>*> &listOfT13eLists, int sock)
 {
     string msg;
@@ -410,6 +459,43 @@ void MessageBuilder::sendIdInfo(CompleteID &id, list<list<Type13Entry*>*> &listO
     }
 }
 
+// each element of t13eListsStr as built by addToString
+void MessageBuilder::sendIdInfo(CompleteID &id, list<string> &t13eListsStr, int sock)
+{
+    string msg;
+    byte type = 252;
+    msg.push_back((char)type);
+    // add initial request string
+    type = 3;
+    string paramstr(id.to20Char());
+    paramstr.insert(0, 1, (char)type);
+    packMessage(&paramstr);
+    Util u;
+    msg.append(u.UllAsByteSeq(paramstr.length()));
+    msg.append(paramstr);
+    // add claims, the lists are not copied
+    vector<string> lengths;
+    lengths.reserve(t13eListsStr.size());
+    vector<struct iovec> parts;
+    addPart(parts, msg.data(), msg.length());
+    list<string>::iterator it;
+    for (it=t13eListsStr.begin(); it!=t13eListsStr.end(); ++it)
+    {
+        if (it->length()<=0) return;
+        lengths.push_back(u.UllAsByteSeq(it->length()));
+        addPart(parts, lengths.back().data(), lengths.back().length());
+        addPart(parts, it->data(), it->length());
+    }
+    if (sendPacked(parts, sock))
+    {
+        //puts("MessageBuilder::IdInfo sent successfully");
+    }
+    else
+    {
+        //puts("MessageBuilder::sendIdInfo unsuccessful");
+    }
+}
+
 void MessageBuilder::sendContactInfo(string &contactInfo, int sock)
 {
     string msg;
@@ -687,6 +773,27 @@ void MessageBuilder::sendSignature(string *t13eStr, int sock)
     }
 }
 
+// for entries which are not held as strings (e.g. pinned in the database)
+void MessageBuilder::sendSignature(const char* t13eData, size_t t13eLength, int sock)
+{
+    Util u;
+    string head;
+    byte type = 12;
+    head.push_back((char)type);
+    head.append(u.UllAsByteSeq(t13eLength));
+    vector<struct iovec> parts;
+    addPart(parts, head.data(), head.length());
+    addPart(parts, t13eData, t13eLength);
+    if (sendPacked(parts, sock))
+    {
+        //puts("MessageBuilder::Signature sent successfully");
+    }
+    else
+    {
+        //puts("MessageBuilder::sendSignature unsuccessful");
+    }
+}
+
 void MessageBuilder::sendNewerIds(unsigned char listType, CompleteID id1, CompleteID id2, int sock)
 {
     if (!getTNotaryNr().isGood() || privateKey==nullptr) return;
@@ -749,24 +856,9 @@ void MessageBuilder::sendNotarizationEntry(list<string> &entriesStr, int sock)
 
 void MessageBuilder::sendNotarizationEntry(list<Type13Entry*> &t13eList, int sock)
 {
-    if (!getTNotaryNr().isGood() || privateKey==nullptr) return;
-
     string msg;
-    byte type = 17;
-    msg.push_back((char)type);
-    string sequenceToSign;
-    if (!addToString(t13eList, sequenceToSign)) return;
-    string *signature = signString(sequenceToSign);
-    msg.append(sequenceToSign);
-    // add signature and notaryNr and time stamp
-    Util u;
-    msg.append(u.UllAsByteSeq(signature->length()+12));
-    msg.append(*signature);
-    delete signature;
-    msg.append(u.UlAsByteSeq(getTNotaryNr().getNotaryNr()));
-    msg.append(u.UllAsByteSeq(systemTimeInMs()));
-    // pack and send
-    packMessage(&msg);
+    if (!buildNotarizationEntryMsg(t13eList, msg)) return;
+    // send
     unsigned long long result = send(sock, msg.c_str(), msg.length(), MSG_NOSIGNAL);
     if (result == msg.length())
     {
@@ -778,9 +870,141 @@ void MessageBuilder::sendNotarizationEntry(list<Type13Entry*> &t13eList, int soc
     }
 }
 
+// builds a signed and packed type 17 message, reusing a cached signature if the signatures list is unchanged
+// (the time stamp is not signed and always set to the current time)
+bool MessageBuilder::buildNotarizationEntryMsg(list<Type13Entry*> &t13eList, string &msg)
+{
+    if (!getTNotaryNr().isGood() || privateKey==nullptr) return false;
+    if (t13eList.size()<=0 || t13eList.front()==nullptr || t13eList.back()==nullptr) return false;
+
+    // try the cache first
+    string key(t13eList.front()->getCompleteID().to20Char());
+    key.append(t13eList.back()->getCompleteID().to20Char());
+    unsigned long long currentTime = systemTimeInMs();
+    Util u;
+    string newMsg;
+    responses_mutex.lock();
+    if (signedResponsesByKey.count(key)>0)
+    {
+        list<SignedResponse>::iterator it = signedResponsesByKey[key];
+        if (it->creationTime + signedResponseMaxAgeInMs > currentTime)
+        {
+            signedResponses.splice(signedResponses.begin(), signedResponses, it);
+            newMsg.append(it->msg);
+            responses_mutex.unlock();
+            newMsg.append(u.UllAsByteSeq(currentTime));
+            packMessage(&newMsg);
+            msg.append(newMsg);
+            return true;
+        }
+        signedResponsesByKey.erase(key);
+        signedResponses.erase(it);
+    }
+    responses_mutex.unlock();
+
+    // build new message
+    byte type = 17;
+    newMsg.push_back((char)type);
+    string sequenceToSign;
+    if (!addToString(t13eList, sequenceToSign)) return false;
+    string *signature = signString(sequenceToSign);
+    newMsg.append(sequenceToSign);
+    // add signature and notaryNr
+    newMsg.append(u.UllAsByteSeq(signature->length()+12));
+    newMsg.append(*signature);
+    delete signature;
+    newMsg.append(u.UlAsByteSeq(getTNotaryNr().getNotaryNr()));
+
+    // store in cache
+    responses_mutex.lock();
+    if (signedResponsesByKey.count(key)<=0)
+    {
+        SignedResponse response;
+        response.key = key;
+        response.msg = newMsg;
+        response.creationTime = currentTime;
+        signedResponses.push_front(response);
+        signedResponsesByKey.insert(pair<string, list<SignedResponse>::iterator>(key, signedResponses.begin()));
+        while (signedResponses.size() > signedResponsesCacheSize)
+        {
+            signedResponsesByKey.erase(signedResponses.back().key);
+            signedResponses.pop_back();
+        }
+    }
+    responses_mutex.unlock();
+
+    // add time stamp
+    newMsg.append(u.UllAsByteSeq(currentTime));
+    packMessage(&newMsg);
+    msg.append(newMsg);
+    return true;
+}
+
+// drops all cached type 17 messages for an entry (after its signatures list has changed)
+void MessageBuilder::forgetNotarizationEntry(CompleteID &entryId)
+{
+    string keyPref(entryId.to20Char());
+    responses_mutex.lock();
+    map<string, list<SignedResponse>::iterator>::iterator it = signedResponsesByKey.lower_bound(keyPref);
+    while (it!=signedResponsesByKey.end() && it->first.compare(0, keyPref.length(), keyPref) == 0)
+    {
+        signedResponses.erase(it->second);
+        it = signedResponsesByKey.erase(it);
+    }
+    responses_mutex.unlock();
+}
+
 unsigned long MessageBuilder::addModulo(unsigned long a, unsigned long b)
 {
     const unsigned long diff = maxLong - a;
     if (b>diff) return b-diff-1;
     else return a+b;
 }
+
+void MessageBuilder::addPart(vector<struct iovec> &parts, const char* data, size_t length)
+{
+    struct iovec part;
+    part.iov_base = (void*) data;
+    part.iov_len = length;
+    parts.push_back(part);
+}
+
+// sends the concatenation of parts as packMessage would pack it, without copying the parts into one string
+bool MessageBuilder::sendPacked(vector<struct iovec> &parts, int sock)
+{
+    unsigned long checkSum = 0;
+    unsigned long long length = 0;
+    for (size_t i=0; i<parts.size(); i++)
+    {
+        const byte* data = (const byte*) parts[i].iov_base;
+        for (size_t j=0; j<parts[i].iov_len; j++)
+        {
+            checkSum = addModulo(checkSum, data[j]);
+        }
+        length += parts[i].iov_len;
+    }
+    Util u;
+    string lenAsSeq = u.UlAsByteSeq(length);
+    const char lenAsSeqReverse[4] = {lenAsSeq.at(3), lenAsSeq.at(2), lenAsSeq.at(1), lenAsSeq.at(0)};
+    string checkSumAsSeq = u.UlAsByteSeq(checkSum);
+    const char checkSumAsSeqReverse[4] = {checkSumAsSeq.at(3), checkSumAsSeq.at(2), checkSumAsSeq.at(1), checkSumAsSeq.at(0)};
+
+    vector<struct iovec> vec;
+    vec.reserve(parts.size()+2);
+    addPart(vec, lenAsSeqReverse, 4);
+    vec.insert(vec.end(), parts.begin(), parts.end());
+    addPart(vec, checkSumAsSeqReverse, 4);
+    if (vec.size() > (size_t) IOV_MAX)
+    {
+        // too many parts for one call
+        string msg;
+        for (size_t i=0; i<vec.size(); i++) msg.append((const char*) vec[i].iov_base, vec[i].iov_len);
+        unsigned long long result = send(sock, msg.c_str(), msg.length(), MSG_NOSIGNAL);
+        return (result == msg.length());
+    }
+    struct msghdr message = {};
+    message.msg_iov = &vec[0];
+    message.msg_iovlen = vec.size();
+    unsigned long long result = sendmsg(sock, &message, MSG_NOSIGNAL);
+    return (result == length+8);
+}
@@ -0,0 +1,56 @@
+#include "NodeStatus.h"
+
+NodeStatus::NodeStatus(unsigned long long maxAgeInMs) : maxAge(maxAgeInMs), status(0), publications(0)
+{
+
+}
+
+NodeStatus::~NodeStatus()
+{
+
+}
+
+void NodeStatus::publish(bool actingWithBuffer, bool upToDate, unsigned long long currentTime)
+{
+    unsigned long long word = currentTime << flagsNum;
+    if (actingWithBuffer) word |= flagActingWithBuffer;
+    if (upToDate) word |= flagUpToDate;
+    status.store(word, memory_order_release);
+    publications++;
+}
+
+// an outdated status (e.g. if the internal thread is stuck) is treated as not acting and not up-to-date
+unsigned char NodeStatus::loadFlags()
+{
+    const unsigned long long word = status.load(memory_order_acquire);
+    const unsigned long long publishTime = word >> flagsNum;
+    const unsigned long long currentTime = chrono::duration_cast<chrono::milliseconds>(
+            chrono::system_clock::now().time_since_epoch()).count();
+    if (publishTime + maxAge < currentTime) return 0;
+    return (unsigned char) (word & ((1 << flagsNum) - 1));
+}
+
+bool NodeStatus::isActingAndUpToDate()
+{
+    const unsigned char flags = loadFlags();
+    return (flags & flagActingWithBuffer) && (flags & flagUpToDate);
+}
+
+bool NodeStatus::isUpToDate()
+{
+    return (loadFlags() & flagUpToDate) != 0;
+}
+
+void NodeStatus::report(string &msg)
+{
+    const unsigned long long word = status.load(memory_order_acquire);
+    msg.append("published: ");
+    msg.append(to_string(publications));
+    msg.append(" times, last at ");
+    msg.append(to_string(word >> flagsNum));
+    msg.append(", acting (with buffer): ");
+    msg.append((word & flagActingWithBuffer) ? "yes" : "no");
+    msg.append(", up-to-date: ");
+    msg.append((word & flagUpToDate) ? "yes" : "no");
+    if (loadFlags() == 0 && (word & ((1 << flagsNum) - 1)) != 0) msg.append(" (outdated)");
+}
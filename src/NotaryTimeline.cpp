@@ -0,0 +1,79 @@
+#include "NotaryTimeline.h"
+
+NotaryTimeline::NotaryTimeline()
+{
+    shared_ptr<Timeline> empty = make_shared<Timeline>();
+    empty->version = 0;
+    timeline = empty;
+}
+
+NotaryTimeline::~NotaryTimeline()
+{
+
+}
+
+void NotaryTimeline::reset(vector<vector<unsigned long long>> &tenureStarts)
+{
+    write_mutex.lock();
+    shared_ptr<const Timeline> current = atomic_load(&timeline);
+    shared_ptr<Timeline> next = make_shared<Timeline>();
+    next->version = current->version + 1;
+    for (size_t i=0; i<tenureStarts.size(); i++)
+    {
+        next->lineages.push_back(make_shared<const Lineage>(tenureStarts[i]));
+    }
+    atomic_store(&timeline, shared_ptr<const Timeline>(next));
+    write_mutex.unlock();
+}
+
+// notaries in between which are not known yet get ULLONG_MAX
+void NotaryTimeline::setTenureStart(unsigned short lineageNr, unsigned long notaryNr, unsigned long long tenureStart)
+{
+    if (lineageNr == 0 || notaryNr == 0) return;
+    write_mutex.lock();
+    shared_ptr<const Timeline> current = atomic_load(&timeline);
+    shared_ptr<Timeline> next = make_shared<Timeline>(*current);
+    next->version = current->version + 1;
+    while (next->lineages.size() < lineageNr) next->lineages.push_back(make_shared<const Lineage>());
+    shared_ptr<Lineage> lineage = make_shared<Lineage>(*next->lineages[lineageNr-1]);
+    if (lineage->size() < notaryNr) lineage->resize(notaryNr, ULLONG_MAX);
+    (*lineage)[notaryNr-1] = tenureStart;
+    next->lineages[lineageNr-1] = lineage;
+    atomic_store(&timeline, shared_ptr<const Timeline>(next));
+    write_mutex.unlock();
+}
+
+unsigned long long NotaryTimeline::getTenureStart(unsigned short lineageNr, unsigned long notaryNr)
+{
+    shared_ptr<const Timeline> current = atomic_load(&timeline);
+    if (lineageNr == 0 || lineageNr > current->lineages.size()) return ULLONG_MAX;
+    const Lineage &lineage = *current->lineages[lineageNr-1];
+    if (notaryNr == 0 || notaryNr > lineage.size()) return ULLONG_MAX;
+    return lineage[notaryNr-1];
+}
+
+unsigned long NotaryTimeline::getNotariesCount(unsigned short lineageNr)
+{
+    shared_ptr<const Timeline> current = atomic_load(&timeline);
+    if (lineageNr == 0 || lineageNr > current->lineages.size()) return 0;
+    return current->lineages[lineageNr-1]->size();
+}
+
+unsigned long long NotaryTimeline::getVersion()
+{
+    return atomic_load(&timeline)->version;
+}
+
+void NotaryTimeline::report(string &msg)
+{
+    shared_ptr<const Timeline> current = atomic_load(&timeline);
+    msg.append("version: ");
+    msg.append(to_string(current->version));
+    for (size_t i=0; i<current->lineages.size(); i++)
+    {
+        msg.append(", notaries in lineage ");
+        msg.append(to_string(i+1));
+        msg.append(": ");
+        msg.append(to_string(current->lineages[i]->size()));
+    }
+}
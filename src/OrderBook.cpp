@@ -0,0 +1,220 @@
+#include "OrderBook.h"
+
+OrderBook::OrderBook()
+{
+    for (size_t i=0; i<orderBookBucketsNum; i++) buckets[i] = make_shared<const Bucket>();
+}
+
+OrderBook::~OrderBook()
+{
+
+}
+
+bool OrderBook::CompareBookKeys::operator()(const BookKey &a, const BookKey &b) const
+{
+    CompleteID::CompareIDs lessThan;
+    if (lessThan(a.currencyOId, b.currencyOId)) return true;
+    if (lessThan(b.currencyOId, a.currencyOId)) return false;
+    if (lessThan(a.currencyRId, b.currencyRId)) return true;
+    if (lessThan(b.currencyRId, a.currencyRId)) return false;
+    return lessThan(a.ownerId, b.ownerId);
+}
+
+bool OrderBook::CompareBookEntries::operator()(const BookEntry &a, const BookEntry &b) const
+{
+    if (a.range != b.range) return a.range < b.range;
+    if (a.ratio != b.ratio) return a.ratio < b.ratio;
+    return CompleteID::CompareIDs()(a.id, b.id);
+}
+
+size_t OrderBook::getBucket(CompleteID &currencyOId, CompleteID &currencyRId)
+{
+    unsigned long long h = currencyOId.getTimeStamp() ^ currencyOId.getID() ^ currencyOId.getNotary();
+    h = h * 31 + (currencyRId.getTimeStamp() ^ currencyRId.getID() ^ currencyRId.getNotary());
+    return hash<unsigned long long>()(h) % orderBookBucketsNum;
+}
+
+// write_mutex must be locked for this
+void OrderBook::insert(Offer &offer)
+{
+    BookKey key;
+    key.currencyOId = offer.currencyOId;
+    key.currencyRId = offer.currencyRId;
+    BookEntry entry;
+    entry.range = offer.range;
+    entry.ratio = offer.ratio;
+    entry.id = offer.id;
+    books[key].insert(entry);
+    changedBooks.insert(key);
+    key.ownerId = offer.ownerId;
+    books[key].insert(entry);
+    changedBooks.insert(key);
+}
+
+// write_mutex must be locked for this
+void OrderBook::erase(Offer &offer)
+{
+    BookKey key;
+    key.currencyOId = offer.currencyOId;
+    key.currencyRId = offer.currencyRId;
+    BookEntry entry;
+    entry.range = offer.range;
+    entry.ratio = offer.ratio;
+    entry.id = offer.id;
+    for (unsigned char i=0; i<2; i++)
+    {
+        if (i==1) key.ownerId = offer.ownerId;
+        map<BookKey, Book, CompareBookKeys>::iterator it = books.find(key);
+        if (it == books.end()) continue;
+        it->second.erase(entry);
+        if (it->second.empty()) books.erase(it);
+        changedBooks.insert(key);
+    }
+}
+
+void OrderBook::add(CompleteID &offerId, CompleteID &ownerId, CompleteID &currencyOId, CompleteID &currencyRId,
+                    unsigned short range, double amountR, double ratio)
+{
+    Offer offer;
+    offer.id = offerId;
+    offer.ownerId = ownerId;
+    offer.currencyOId = currencyOId;
+    offer.currencyRId = currencyRId;
+    offer.range = range;
+    offer.ratio = (ratio == ratio ? ratio : HUGE_VAL); // nan would break the order
+    offer.amountR = amountR;
+    write_mutex.lock();
+    map<CompleteID, Offer, CompleteID::CompareIDs>::iterator it = offers.find(offerId);
+    if (it != offers.end())
+    {
+        erase(it->second);
+        it->second = offer;
+    }
+    else it = offers.insert(pair<CompleteID, Offer>(offerId, offer)).first;
+    insert(it->second);
+    write_mutex.unlock();
+}
+
+bool OrderBook::remove(CompleteID &offerId)
+{
+    write_mutex.lock();
+    map<CompleteID, Offer, CompleteID::CompareIDs>::iterator it = offers.find(offerId);
+    if (it == offers.end())
+    {
+        write_mutex.unlock();
+        return false;
+    }
+    erase(it->second);
+    offers.erase(it);
+    write_mutex.unlock();
+    return true;
+}
+
+bool OrderBook::setRatio(CompleteID &offerId, double ratio)
+{
+    if (ratio != ratio) ratio = HUGE_VAL;
+    write_mutex.lock();
+    map<CompleteID, Offer, CompleteID::CompareIDs>::iterator it = offers.find(offerId);
+    if (it == offers.end())
+    {
+        write_mutex.unlock();
+        return false;
+    }
+    if (it->second.ratio != ratio)
+    {
+        erase(it->second);
+        it->second.ratio = ratio;
+        insert(it->second);
+    }
+    write_mutex.unlock();
+    return true;
+}
+
+// replaces the changed books in the snapshots of their buckets (each bucket is copied once)
+void OrderBook::publish()
+{
+    write_mutex.lock();
+    map<size_t, shared_ptr<Bucket>> newBuckets;
+    set<BookKey, CompareBookKeys>::iterator it;
+    for (it=changedBooks.begin(); it!=changedBooks.end(); ++it)
+    {
+        CompleteID currencyOId = it->currencyOId;
+        CompleteID currencyRId = it->currencyRId;
+        const size_t b = getBucket(currencyOId, currencyRId);
+        map<size_t, shared_ptr<Bucket>>::iterator bucketIt = newBuckets.find(b);
+        if (bucketIt == newBuckets.end())
+        {
+            shared_ptr<Bucket> bucket = make_shared<Bucket>(*atomic_load(&buckets[b]));
+            bucketIt = newBuckets.insert(pair<size_t, shared_ptr<Bucket>>(b, bucket)).first;
+        }
+        map<BookKey, Book, CompareBookKeys>::iterator bookIt = books.find(*it);
+        if (bookIt == books.end()) bucketIt->second->erase(*it);
+        else (*bucketIt->second)[*it] = make_shared<const PublishedBook>(bookIt->second.begin(), bookIt->second.end());
+    }
+    changedBooks.clear();
+    map<size_t, shared_ptr<Bucket>>::iterator bucketIt;
+    for (bucketIt=newBuckets.begin(); bucketIt!=newBuckets.end(); ++bucketIt)
+    {
+        atomic_store(&buckets[bucketIt->first], shared_ptr<const Bucket>(bucketIt->second));
+    }
+    write_mutex.unlock();
+}
+
+bool OrderBook::getOffer(CompleteID &offerId, Offer &target)
+{
+    write_mutex.lock();
+    map<CompleteID, Offer, CompleteID::CompareIDs>::iterator it = offers.find(offerId);
+    const bool found = (it != offers.end());
+    if (found) target = it->second;
+    write_mutex.unlock();
+    return found;
+}
+
+// ownerId with notary 0 for offers of all owners, does not lock
+size_t OrderBook::getOffers(CompleteID &ownerId, CompleteID &currencyOId, CompleteID &currencyRId, unsigned short range,
+                            size_t maxNum, list<CompleteID> &idsList)
+{
+    if (!idsList.empty()) return 0;
+    BookKey key;
+    if (ownerId.getNotary()>0) key.ownerId = ownerId;
+    key.currencyOId = currencyOId;
+    key.currencyRId = currencyRId;
+    shared_ptr<const Bucket> bucket = atomic_load(&buckets[getBucket(currencyOId, currencyRId)]);
+    Bucket::const_iterator it = bucket->find(key);
+    if (it == bucket->end()) return 0;
+    shared_ptr<const PublishedBook> book = it->second;
+    BookEntry first;
+    first.range = range;
+    first.ratio = -HUGE_VAL;
+    PublishedBook::const_iterator pos = lower_bound(book->begin(), book->end(), first, CompareBookEntries());
+    for (; pos != book->end() && pos->range == range && idsList.size() < maxNum; ++pos)
+    {
+        idsList.push_back(pos->id);
+    }
+    return idsList.size();
+}
+
+void OrderBook::clear()
+{
+    write_mutex.lock();
+    offers.clear();
+    books.clear();
+    changedBooks.clear();
+    for (size_t i=0; i<orderBookBucketsNum; i++) atomic_store(&buckets[i], make_shared<const Bucket>());
+    write_mutex.unlock();
+}
+
+void OrderBook::report(string &msg)
+{
+    write_mutex.lock();
+    const size_t offersNum = offers.size();
+    const size_t booksNum = books.size();
+    const size_t changedNum = changedBooks.size();
+    write_mutex.unlock();
+    msg.append("offers: ");
+    msg.append(to_string(offersNum));
+    msg.append(", books: ");
+    msg.append(to_string(booksNum));
+    msg.append(", books not yet published: ");
+    msg.append(to_string(changedNum));
+}
@@ -623,24 +623,26 @@ void OtherServersHandler::sendConsiderNotarizationEntryToAll(CompleteID &firstID
     }
 }
 
-void OtherServersHandler::sendNotarizationEntryToAll(list<Type13Entry*> &t13eList)
+// announces the ids following the previously announced head of the list (see Database::loadNewerEntriesIds)
+void OtherServersHandler::sendListHeadToAll(unsigned char listType, CompleteID &previousHead, CompleteID &id1, CompleteID &id2)
 {
     if (!msgBuilder->getTNotaryNr().isGood()) return;
 
     // build message
     string msg;
-    byte type = 17;
+    byte type = 22;
     msg.push_back((char)type);
+    Util u;
     string sequenceToSign;
-    if (!msgBuilder->addToString(t13eList, sequenceToSign)) return;
+    sequenceToSign.append(u.UcAsByteSeq(listType));
+    sequenceToSign.append(u.UlAsByteSeq(msgBuilder->getTNotaryNr().getNotaryNr()));
+    sequenceToSign.append(previousHead.to20Char());
+    sequenceToSign.append(id1.to20Char());
+    sequenceToSign.append(id2.to20Char());
     string *signature = msgBuilder->signString(sequenceToSign);
     msg.append(sequenceToSign);
-    Util u;
-    msg.append(u.UllAsByteSeq(signature->length()+12));
     msg.append(*signature);
     delete signature;
-    msg.append(u.UlAsByteSeq(msgBuilder->getTNotaryNr().getNotaryNr()));
-    msg.append(u.UllAsByteSeq(systemTimeInMs()));
     msgBuilder->packMessage(&msg);
 
     // get reachableNotaries
@@ -660,6 +662,31 @@ void OtherServersHandler::sendNotarizationEntryToAll(list<Type13Entry*> &t13eLis
     }
 }
 
+void OtherServersHandler::sendNotarizationEntryToAll(list<Type13Entry*> &t13eList)
+{
+    if (!msgBuilder->getTNotaryNr().isGood()) return;
+
+    // build message
+    string msg;
+    if (!msgBuilder->buildNotarizationEntryMsg(t13eList, msg)) return;
+
+    // get reachableNotaries
+    set<unsigned long> reachableNotaries;
+    contacts_mutex.lock();
+    map<unsigned long, ContactHandler*>::iterator it;
+    for (it=contactsReachable.begin(); it!=contactsReachable.end(); ++it)
+    {
+        reachableNotaries.insert(it->first);
+    }
+    contacts_mutex.unlock();
+
+    // send to reachable notaries
+    for (set<unsigned long>::iterator iter=reachableNotaries.begin(); iter!=reachableNotaries.end(); ++iter)
+    {
+        sendMessage(*iter, msg);
+    }
+}
+
 void OtherServersHandler::sendContactsRqst()
 {
     unsigned long notaryNr = getSomeReachableNotary();
@@ -84,6 +84,9 @@ void RequestProcessor::process(const size_t n, byte *request, const int socket)
     case 21:
         heartBeatRequest(socket);
         break;
+    case 22:
+        listHeadRequest(n, request);
+        break;
     default:
         return;
     }
@@ -105,21 +108,20 @@ void RequestProcessor::pblcKeyInfoRequest(const size_t n, byte *request, const i
 {
     string pblcKeyStr;
     for (size_t i=1; i<n; i++) pblcKeyStr.push_back((char)request[i]);
-    db->lock();
+    db->lockShared();
     CompleteID firstId = db->getFirstID(&pblcKeyStr);
-    db->unlock();
+    db->unlockShared();
     if (firstId.getNotary() <= 0) return;
-    list<Type13Entry*> t13eList;
-    if (loadSupportingType13Entries(firstId, t13eList))
+    string t13eListStr;
+    if (loadSupportingChains(firstId, t13eListStr))
     {
         // send t13eList
-        msgBuilder->sendPblcKeyInfo(t13eList, socket);
+        msgBuilder->sendPblcKeyInfo(t13eListStr, socket);
     }
     else
     {
         puts("pblcKeyInfoRequest: t13eList could not be loaded");
     }
-    deleteContent(t13eList);
 }
 
 void RequestProcessor::currOrOblInfoRequest(const size_t n, byte *request, const int socket)
@@ -164,16 +166,15 @@ void RequestProcessor::currOrOblInfoRequest(const size_t n, byte *request, const
         return;
     }
     // get signature entries and send
-    list<Type13Entry*> t13eList;
-    if (loadSupportingType13Entries(firstId, t13eList))
+    string t13eListStr;
+    if (loadSupportingChains(firstId, t13eListStr))
     {
-        msgBuilder->sendCurrOrOblInfo(t13eList, socket);
+        msgBuilder->sendCurrOrOblInfo(t13eListStr, socket);
     }
     else
     {
         puts("currOrOblInfoRequest: t13eList could not be loaded");
     }
-    deleteContent(t13eList);
 }
 
 void RequestProcessor::refInfoRequest(const size_t n, byte *request, const int socket)
@@ -186,9 +187,9 @@ void RequestProcessor::refInfoRequest(const size_t n, byte *request, const int s
     dum = str.substr(20,20);
     CompleteID liquiId(dum);
     // load info from db
-    db->lock();
+    db->lockShared();
     RefereeInfo *refInfo = db->getRefereeInfo(keyId, liquiId);
-    db->unlock();
+    db->unlockShared();
     if (refInfo == nullptr) return;
     // send
     msgBuilder->sendRefInfo(str, *refInfo, socket);
@@ -207,9 +208,9 @@ void RequestProcessor::notaryInfoRequest(const size_t n, byte *request, const in
     dum = str.substr(4+lenOfKey, 20);
     CompleteID liquiId(dum);
     // load info from db
-    db->lock();
+    db->lockShared();
     NotaryInfo *notaryInfo = db->getNotaryInfo(&publicKey, liquiId);
-    db->unlock();
+    db->unlockShared();
     if (notaryInfo == nullptr) return;
     // send
     msgBuilder->sendNotaryInfo(str, *notaryInfo, socket);
@@ -228,23 +229,14 @@ void RequestProcessor::idInfoRequest(const size_t n, byte *request, const int so
     db->getRelatedEntries(id, idsList);
     db->unlock();
     // load signatures
-    list<list<Type13Entry*>*> listOfT13eLists;
-    list<CompleteID>::iterator it;
-    for (it=idsList.begin(); it!=idsList.end(); ++it)
+    list<string> t13eListsStr;
+    if (!loadSupportingChains(idsList, t13eListsStr))
     {
-        list<Type13Entry*> *nextList = new list<Type13Entry*>();
-        if (!loadSupportingType13Entries(*it, *nextList))
-        {
-            puts("idInfoRequest: nextList could not be loaded");
-            delete nextList;
-            deleteContent(listOfT13eLists);
-            return;
-        }
-        listOfT13eLists.push_back(nextList);
+        puts("idInfoRequest: t13e lists could not be loaded");
+        return;
     }
     // send
-    msgBuilder->sendIdInfo(id, listOfT13eLists, socket);
-    deleteContent(listOfT13eLists);
+    msgBuilder->sendIdInfo(id, t13eListsStr, socket);
 }
 
 void RequestProcessor::claimsInfoRequest(const size_t n, byte *request, const int socket)
@@ -277,23 +269,15 @@ void RequestProcessor::claimsInfoRequest(const size_t n, byte *request, const in
     if (pos!=str.length()) return;
     // get the ids
     list<CompleteID> idsList;
-    db->lock();
+    db->lockShared();
     db->getClaims(id, currencyId, maxClaimId, maxClaimsNum, idsList);
-    db->unlock();
+    db->unlockShared();
     // load signatures
     list<list<Type13Entry*>*> listOfT13eLists;
-    list<CompleteID>::iterator it;
-    for (it=idsList.begin(); it!=idsList.end(); ++it)
+    if (!loadSupportingType13Entries(idsList, listOfT13eLists))
     {
-        list<Type13Entry*> *nextList = new list<Type13Entry*>();
-        if (!loadSupportingType13Entries(*it, *nextList))
-        {
-            puts("claimsInfoRequest: nextList could not be loaded");
-            delete nextList;
-            deleteContent(listOfT13eLists);
-            return;
-        }
-        listOfT13eLists.push_back(nextList);
+        puts("claimsInfoRequest: t13e lists could not be loaded");
+        return;
     }
     // send
     msgBuilder->sendClaims(str, listOfT13eLists, socket);
@@ -348,7 +332,7 @@ void RequestProcessor::decThrInfoRequest(const size_t n, byte *request, const in
     }
     // get the ids
     list<CompleteID> idsList;
-    db->lock();
+    db->lockShared();
     if (currencyId.isZero())
     {
         db->getNotaryApplications(keyId, applicantSpecified, spec, minApplId, maxThreadsNum, idsList);
@@ -358,21 +342,13 @@ void RequestProcessor::decThrInfoRequest(const size_t n, byte *request, const in
         if (isOpPr) db->getApplications("OP", keyId, applicantSpecified, currencyId, spec, minApplId, maxThreadsNum, idsList);
         else db->getApplications("AR", keyId, applicantSpecified, currencyId, spec, minApplId, maxThreadsNum, idsList);
     }
-    db->unlock();
+    db->unlockShared();
     // load signatures
     list<list<Type13Entry*>*> listOfT13eLists;
-    list<CompleteID>::iterator it;
-    for (it=idsList.begin(); it!=idsList.end(); ++it)
+    if (!loadSupportingType13Entries(idsList, listOfT13eLists))
     {
-        list<Type13Entry*> *nextList = new list<Type13Entry*>();
-        if (!loadSupportingType13Entries(*it, *nextList))
-        {
-            puts("decThrInfoRequest: nextList could not be loaded");
-            delete nextList;
-            deleteContent(listOfT13eLists);
-            return;
-        }
-        listOfT13eLists.push_back(nextList);
+        puts("decThrInfoRequest: t13e lists could not be loaded");
+        return;
     }
     // send
     msgBuilder->sendDecThreads(str, listOfT13eLists, socket);
@@ -414,26 +390,18 @@ void RequestProcessor::exchangeOffersInfoRequest(const size_t n, byte *request,
     if (pos!=str.length()) return;
     // get the ids
     list<CompleteID> idsList;
-    db->lock();
+    db->lockShared();
     db->getExchangeOffers(id, currencyOId, currencyRId, rangeNum, maxTransRqstsNum, idsList);
-    db->unlock();
+    db->unlockShared();
     // load signatures
     list<list<Type13Entry*>*> listOfT13eLists;
-    list<CompleteID>::iterator it;
-    for (it=idsList.begin(); it!=idsList.end(); ++it)
+    if (!loadSupportingType13Entries(idsList, listOfT13eLists))
     {
-        list<Type13Entry*> *nextList = new list<Type13Entry*>();
-        if (!loadSupportingType13Entries(*it, *nextList))
-        {
-            puts("exchangeOffersInfoRequest: nextList could not be loaded");
-            delete nextList;
-            deleteContent(listOfT13eLists);
-            return;
-        }
-        listOfT13eLists.push_back(nextList);
+        puts("exchangeOffersInfoRequest: t13e lists could not be loaded");
+        return;
     }
-    // update exchange offer ratios in db
-    db->lock();
+    // update exchange offer ratios (stored later by the internal thread)
+    db->lockShared();
     list<list<Type13Entry*>*>::iterator iter;
     for (iter=listOfT13eLists.begin(); iter!=listOfT13eLists.end(); ++iter)
     {
@@ -447,7 +415,7 @@ void RequestProcessor::exchangeOffersInfoRequest(const size_t n, byte *request,
             delete t12e;
         }
     }
-    db->unlock();
+    db->unlockShared();
     // send
     byte type = 9;
     str.insert(0, 1, (char)type);
@@ -485,23 +453,15 @@ void RequestProcessor::transferRqstsInfoRequest(const size_t n, byte *request, c
     if (pos!=str.length()) return;
     // get the ids
     list<CompleteID> idsList;
-    db->lock();
+    db->lockShared();
     db->getTransferRequests(id, currencyId, maxTransId, maxTransRqstsNum, idsList);
-    db->unlock();
+    db->unlockShared();
     // load signatures
     list<list<Type13Entry*>*> listOfT13eLists;
-    list<CompleteID>::iterator it;
-    for (it=idsList.begin(); it!=idsList.end(); ++it)
+    if (!loadSupportingType13Entries(idsList, listOfT13eLists))
     {
-        list<Type13Entry*> *nextList = new list<Type13Entry*>();
-        if (!loadSupportingType13Entries(*it, *nextList))
-        {
-            puts("transferRqstsInfoRequest: nextList could not be loaded");
-            delete nextList;
-            deleteContent(listOfT13eLists);
-            return;
-        }
-        listOfT13eLists.push_back(nextList);
+        puts("transferRqstsInfoRequest: t13e lists could not be loaded");
+        return;
     }
     // send
     byte type = 6;
@@ -512,10 +472,7 @@ void RequestProcessor::transferRqstsInfoRequest(const size_t n, byte *request, c
 
 void RequestProcessor::nextClaimInfoRequest(const size_t n, byte *request, const int socket)
 {
-    unsigned long long wellConnectedSince = sh->getWellConnectedSince();
-    db->lock();
-    bool actingAndNotBanned = db->amCurrentlyActingWithBuffer() && db->dbUpToDate(wellConnectedSince);
-    db->unlock();
+    bool actingAndNotBanned = db->amActingAndUpToDate();
     if (!actingAndNotBanned) return;
     string str;
     for (size_t i=1; i<n; i++) str.push_back((char)request[i]);
@@ -553,42 +510,147 @@ void RequestProcessor::nextClaimInfoRequest(const size_t n, byte *request, const
 bool RequestProcessor::loadSupportingType13Entries(CompleteID &id, list<Type13Entry*> &target)
 {
     if (target.size()>0) return false;
-    list<Type13Entry*> t13eListInc;
-    db->lock();
-    CompleteID firstID = db->getFirstID(id);
-    CompleteID currentId = db->getLatestID(firstID);
-    db->unlock();
-    while (currentId.getNotary()>0)
+    list<CompleteID> ids;
+    ids.push_back(id);
+    list<list<Type13Entry*>*> targetLists;
+    if (!loadSupportingType13Entries(ids, targetLists)) return false;
+    target.swap(*targetLists.front());
+    deleteContent(targetLists);
+    return (target.size()>0);
+}
+
+// loads the chains of several ids together, each step of all chains with one db access
+bool RequestProcessor::loadSupportingType13Entries(list<CompleteID> &ids, list<list<Type13Entry*>*> &targetLists)
+{
+    if (targetLists.size()>0) return false;
+    const size_t n = ids.size();
+    vector<list<Type13Entry*>*> targets;
+    vector<CompleteID> currentIds;
+    db->lockShared();
+    list<CompleteID>::iterator iter;
+    for (iter=ids.begin(); iter!=ids.end(); ++iter)
     {
-        // load entries for this id
-        t13eListInc.clear();
-        if (!buildType13Entries(currentId, t13eListInc) || t13eListInc.size()<1)
+        CompleteID firstID = db->getFirstID(*iter);
+        currentIds.push_back(db->getLatestID(firstID));
+        list<Type13Entry*> *target = new list<Type13Entry*>();
+        targets.push_back(target);
+        targetLists.push_back(target);
+    }
+    db->unlockShared();
+    bool success = true;
+    while (success)
+    {
+        // collect ids of this step
+        vector<size_t> positions;
+        vector<CompleteID> stepIds;
+        for (size_t i=0; i<n; i++)
         {
-            deleteContent(target);
-            deleteContent(t13eListInc);
-            return false;
+            if (currentIds[i].getNotary()<=0) continue;
+            positions.push_back(i);
+            stepIds.push_back(currentIds[i]);
         }
-        // include into main list
-        list<Type13Entry*>::iterator it;
-        list<Type13Entry*>::iterator it2=target.begin();
-        for (it=t13eListInc.begin(); it!=t13eListInc.end(); ++it)
+        if (stepIds.empty()) break;
+        // load entries for these ids
+        vector<list<Type13Entry*>> stepLists(stepIds.size());
+        db->lockShared();
+        success = db->loadType13Entries(stepIds, stepLists);
+        db->unlockShared();
+        for (size_t k=0; k<stepIds.size(); k++)
         {
-            Type13Entry *t13e = *it;
-            if (t13e==nullptr || !t13e->isGood())
+            list<Type13Entry*> &t13eListInc = stepLists[k];
+            if (success && (!completeType13Entries(stepIds[k], t13eListInc) || t13eListInc.size()<1)) success = false;
+            list<Type13Entry*>::iterator it;
+            for (it=t13eListInc.begin(); it!=t13eListInc.end() && success; ++it)
+            {
+                Type13Entry *t13e = *it;
+                if (t13e==nullptr || !t13e->isGood())
+                {
+                    puts("RequestProcessor::loadSupportingType13Entries: bad t13e, unexpected");
+                    success = false;
+                }
+            }
+            if (!success)
             {
-                puts("RequestProcessor::loadSupportingType13Entries: bad t13e, unexpected");
-                deleteContent(target);
                 deleteContent(t13eListInc);
-                return false;
+                continue;
             }
-            target.insert(it2, t13e);
+            // get next id
+            Type13Entry *firstInInc = t13eListInc.front();
+            CompleteID nextId = firstInInc->getPredecessorID();
+            if (nextId == firstInInc->getCompleteID()) nextId=CompleteID();
+            currentIds[positions[k]] = nextId;
+            // include into main list
+            list<Type13Entry*> *target = targets[positions[k]];
+            target->insert(target->begin(), t13eListInc.begin(), t13eListInc.end());
         }
-        // get next id
-        Type13Entry *firstInInc = t13eListInc.front();
-        currentId = firstInInc->getPredecessorID();
-        if (currentId == firstInInc->getCompleteID()) currentId=CompleteID();
     }
-    return (target.size()>0);
+    for (size_t i=0; i<n && success; i++)
+    {
+        if (targets[i]->size()<1) success = false;
+    }
+    if (!success) deleteContent(targetLists);
+    return success;
+}
+
+bool RequestProcessor::loadSupportingChains(CompleteID &id, string &target)
+{
+    list<CompleteID> ids;
+    ids.push_back(id);
+    list<string> targets;
+    if (!loadSupportingChains(ids, targets)) return false;
+    target.swap(targets.front());
+    return true;
+}
+
+// like loadSupportingType13Entries, but the chains are serialized and served from the cache if possible
+bool RequestProcessor::loadSupportingChains(list<CompleteID> &ids, list<string> &targets)
+{
+    if (targets.size()>0) return false;
+    // look up cache
+    list<CompleteID> missingIds;
+    list<CompleteID> missingFirstIds;
+    list<string> missingStamps;
+    list<list<string>::iterator> missingTargets;
+    db->lockShared();
+    list<CompleteID>::iterator iter;
+    for (iter=ids.begin(); iter!=ids.end(); ++iter)
+    {
+        CompleteID firstId = db->getFirstID(*iter);
+        targets.push_back(string());
+        string stamp;
+        if (firstId.getNotary()>0 && db->loadCachedChain(firstId, stamp, targets.back())) continue;
+        missingIds.push_back(*iter);
+        missingFirstIds.push_back(firstId);
+        missingStamps.push_back(stamp);
+        missingTargets.push_back(--targets.end());
+    }
+    db->unlockShared();
+    if (missingIds.empty()) return true;
+    // load and serialize missing chains
+    list<list<Type13Entry*>*> listOfT13eLists;
+    if (!loadSupportingType13Entries(missingIds, listOfT13eLists))
+    {
+        targets.clear();
+        return false;
+    }
+    list<list<Type13Entry*>*>::iterator listIt = listOfT13eLists.begin();
+    list<CompleteID>::iterator idIt = missingFirstIds.begin();
+    list<string>::iterator stampIt = missingStamps.begin();
+    list<list<string>::iterator>::iterator targetIt = missingTargets.begin();
+    bool success = true;
+    for (; listIt!=listOfT13eLists.end(); ++listIt, ++idIt, ++stampIt, ++targetIt)
+    {
+        string &chainStr = **targetIt;
+        if (!msgBuilder->addToString(**listIt, chainStr))
+        {
+            success = false;
+            break;
+        }
+        if (idIt->getNotary()>0) db->cacheChain(*idIt, *stampIt, chainStr);
+    }
+    deleteContent(listOfT13eLists);
+    if (!success) targets.clear();
+    return success;
 }
 
 void RequestProcessor::deleteContent(list<Type13Entry*> &entries)
@@ -821,7 +883,66 @@ void RequestProcessor::considerNewerEntriesRequest(const size_t n, byte *request
         db->unlock();
         return;
     }
+    db->unlock();
+    reportNewerEntries(listType, notaryNr, id1, id2);
+}
+
+// announcement of the sender's list head, applied only if no earlier announcement was missed
+void RequestProcessor::listHeadRequest(const size_t n, byte *request)
+{
+    string str;
+    for (size_t i=1; i<n; i++) str.push_back((char)request[i]);
+    if (str.length()<66) return;
+    // extract listType
+    Util u;
+    size_t pos = 0;
+    string dum;
+    dum = str.substr(pos,1);
+    unsigned char listType = u.byteSeqAsUc(dum);
+    pos+=1;
+    // extract notaryNr
+    dum = str.substr(pos,4);
+    unsigned long notaryNr = u.byteSeqAsUl(dum);
+    pos+=4;
+    // extract previously announced head
+    dum = str.substr(pos,20);
+    CompleteID previousHead(dum);
+    pos+=20;
+    // extract id1
+    dum = str.substr(pos,20);
+    CompleteID id1(dum);
+    pos+=20;
+    // extract id2
+    dum = str.substr(pos,20);
+    CompleteID id2(dum);
+    pos+=20;
+    // extract signature
+    string signedSequence = str.substr(0,65);
+    string signature = str.substr(pos,str.length()-65);
+    // check signature
+    db->lock();
+    if (!db->verifySignature(signedSequence, signature, notaryNr, db->systemTimeInMs()))
+    {
+        db->unlock();
+        return;
+    }
+    CompleteID individualUpToDateID = db->getIndividualUpToDateID(listType, notaryNr);
+    db->unlock();
+    if (individualUpToDateID.isZero()) return; // notary not followed
+    // missed an announcement: ask the sender directly
+    if (individualUpToDateID < previousHead)
+    {
+        sh->checkNewerEntry(listType, notaryNr, individualUpToDateID);
+        return;
+    }
+    reportNewerEntries(listType, notaryNr, id1, id2);
+}
+
+// continues with the sender or downloads missing entries
+void RequestProcessor::reportNewerEntries(unsigned char listType, unsigned long notaryNr, CompleteID &id1, CompleteID &id2)
+{
     // report to db
+    db->lock();
     CompleteID newIndividualUpToDateID = db->newEntriesIdsReport(listType, notaryNr, id1, id2);
     if (newIndividualUpToDateID.getNotary()>0)
     {
@@ -880,13 +1001,22 @@ void RequestProcessor::checkNewerEntryRequest(const size_t n, byte *request, con
 bool RequestProcessor::buildType13Entries(CompleteID &id, list<Type13Entry*> &signaturesList)
 {
     db->lock();
-    if (!db->loadType13Entries(id, signaturesList))
+    bool success = db->loadType13Entries(id, signaturesList);
+    db->unlock();
+    if (!success)
     {
-        db->unlock();
         deleteContent(signaturesList);
         signaturesList.clear();
         return false;
     }
+    return completeType13Entries(id, signaturesList);
+}
+
+// checks schedules and appends confirmation entry if necessary
+bool RequestProcessor::completeType13Entries(CompleteID &id, list<Type13Entry*> &signaturesList)
+{
+    if (signaturesList.size()<1) return false;
+    db->lock();
     db->verifySchedules(id);
     // append confirmation entry if necessary
     unsigned short entryLin = db->getType1Entry()->getLineage(id.getTimeStamp());
@@ -917,6 +1047,8 @@ bool RequestProcessor::buildType13Entries(CompleteID &id, list<Type13Entry*> &si
             db->lock();
             db->saveConfirmationEntry(id, confEntry);
             db->unlock();
+            CompleteID entryId = signaturesList.front()->getCompleteID();
+            msgBuilder->forgetNotarizationEntry(entryId);
         }
         delete t12e;
     }
@@ -956,18 +1088,15 @@ void RequestProcessor::initialType13EntryRequest(const size_t n, byte *request,
     if (str.length()!=20) return;
     // extract entry id
     CompleteID id(str);
-    string t13eStr;
-    db->lock();
-    bool success = db->loadType13EntryStr(id, 1, t13eStr);
-    if (!success) success = db->loadType13EntryStr(id, 2, t13eStr);
-    db->unlock();
-    if (success)
+    // the entry stays pinned until it is sent
+    rocksdb::PinnableSlice t13eValue;
+    db->lockShared();
+    bool success = db->loadType13EntryPinned(id, 1, t13eValue);
+    if (!success) success = db->loadType13EntryPinned(id, 2, t13eValue);
+    db->unlockShared();
+    if (success && Database::isInitialT13Str(t13eValue))
     {
-        Type13Entry t13e(t13eStr);
-        if (t13e.isGood() && t13e.getFirstID() == t13e.getCompleteID())
-        {
-            msgBuilder->sendSignature(t13e.getByteSeq(), socket);
-        }
+        msgBuilder->sendSignature(t13eValue.data(), t13eValue.size(), socket);
     }
 }
 
@@ -1186,18 +1315,15 @@ void RequestProcessor::newSignatureRequest(const size_t n, byte *request, const
         delete type13entry;
         return;
     }
-    // schedule own signature based on rank
-    db->addToEntriesToSign(entryID, participationRank+1);
+    // schedule own signature based on rank (rank 0 signs at once, others are fallbacks)
+    db->addToEntriesToSign(entryID, participationRank);
     db->unlock();
     delete type13entry;
 }
 
 void RequestProcessor::notarizationRequest(const size_t n, byte *request, const int socket)
 {
-    unsigned long long wellConnectedSince = sh->getWellConnectedSince();
-    db->lock();
-    bool actingAndNotBanned = db->amCurrentlyActingWithBuffer() && db->dbUpToDate(wellConnectedSince);
-    db->unlock();
+    bool actingAndNotBanned = db->amActingAndUpToDate();
     if (!actingAndNotBanned) return;
     // reconstruct type 12 entry
     stringstream ss;
@@ -1216,9 +1342,7 @@ void RequestProcessor::notarizationRequest(const size_t n, byte *request, const
         return;
     }
     // get acting notaries
-    db->lock();
     set<unsigned long>* actingNotaries = db->getActingNotaries(db->systemTimeInMs());
-    db->unlock();
     actingNotaries->erase(msgBuilder->getTNotaryNr().getNotaryNr());
     // generate relevant notaries list
     set<unsigned long>* notaries = sh->genNotariesList(*actingNotaries);
@@ -1308,24 +1432,15 @@ void RequestProcessor::essentialsRequest(const size_t n, byte *request, const in
     if (pos!=str.length()) return;
     // get the ids
     list<CompleteID> idsList;
-    db->lock();
+    db->lockShared();
     db->getEssentialEntries(minEntryId, idsList);
-    db->unlock();
+    db->unlockShared();
     // load signatures
     list<list<Type13Entry*>*> listOfT13eLists;
-    list<CompleteID>::iterator it;
-    for (it=idsList.begin(); it!=idsList.end(); ++it)
+    if (!loadSupportingType13Entries(idsList, listOfT13eLists))
     {
-        list<Type13Entry*> *nextList = new list<Type13Entry*>();
-        if (!loadSupportingType13Entries(*it, *nextList))
-        {
-            puts("essentialsRequest: nextList could not be loaded");
-            deleteContent(*nextList);
-            delete nextList;
-            deleteContent(listOfT13eLists);
-            return;
-        }
-        listOfT13eLists.push_back(nextList);
+        puts("essentialsRequest: t13e lists could not be loaded");
+        return;
     }
     // send
     msgBuilder->sendEssentials(str, listOfT13eLists, socket);
@@ -0,0 +1,237 @@
+#include "Scheduler.h"
+
+#define maxWaitTimeInMs 1000
+#define maxPreemptionInMs 1000 // tasks of lower priority are not delayed for longer than this
+
+static const char* taskNames[tasksNum] = {"sync WAL", "pack signature lists", "persist exchange offer ratios",
+                                          "update servers", "check new entries", "download new entries",
+                                          "publish node status", "announce list heads", "check up-to-date status",
+                                          "update notaries list", "report contacts", "save checkpoint",
+                                          "grow key filters", "check thread terminations", "sign entries",
+                                          "update renotarization attempts", "start renotarizations",
+                                          "terminate threads", "register key"
+                                         };
+
+static const TaskGroup taskGroups[tasksNum] = {groupSynchronization, groupMaintenance, groupMaintenance,
+                                               groupMaintenance, groupSynchronization, groupSynchronization,
+                                               groupStatus, groupSynchronization, groupMaintenance,
+                                               groupMaintenance, groupMaintenance, groupMaintenance,
+                                               groupMaintenance, groupSigning, groupSigning,
+                                               groupRenotarization, groupRenotarization,
+                                               groupRenotarization, groupRenotarization
+                                              };
+
+static const char* groupNames[taskGroupsNum] = {"status", "signing", "synchronization", "renotarization", "maintenance"};
+
+Scheduler::Scheduler() : stopped(false)
+{
+    for (size_t i=0; i<tasksNum; i++)
+    {
+        tasks[i].deadline = 0; // all tasks run once at start
+        tasks[i].runs = 0;
+        tasks[i].runTimeTotalInMcrS = 0;
+        tasks[i].runTimeMaxInMcrS = 0;
+        tasks[i].lagTotalInMs = 0;
+        tasks[i].lagMaxInMs = 0;
+    }
+    for (size_t i=0; i<taskGroupsNum; i++)
+    {
+        groups[i].runningTasks = 0;
+        groups[i].wakeUps = 0;
+        groups[i].preemptions = 0;
+    }
+}
+
+Scheduler::~Scheduler()
+{
+
+}
+
+unsigned long long Scheduler::systemTimeInMs()
+{
+    return chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+TaskGroup Scheduler::getGroup(SchedulerTask task)
+{
+    return taskGroups[task];
+}
+
+void Scheduler::scheduleAt(SchedulerTask task, unsigned long long time)
+{
+    scheduler_mutex.lock();
+    const bool earlier = (time < tasks[task].deadline);
+    if (earlier) tasks[task].deadline = time;
+    scheduler_mutex.unlock();
+    if (earlier) wakeUp.notify_all();
+}
+
+void Scheduler::trigger(SchedulerTask task)
+{
+    scheduleAt(task, 0);
+}
+
+void Scheduler::postpone(SchedulerTask task, unsigned long long time)
+{
+    scheduler_mutex.lock();
+    if (tasks[task].deadline < time) tasks[task].deadline = time;
+    scheduler_mutex.unlock();
+}
+
+void Scheduler::postponeGroup(TaskGroup group, unsigned long long time)
+{
+    scheduler_mutex.lock();
+    for (size_t i=0; i<tasksNum; i++)
+    {
+        if (taskGroups[i] == group && tasks[i].deadline < time) tasks[i].deadline = time;
+    }
+    scheduler_mutex.unlock();
+}
+
+unsigned long long Scheduler::earliestDeadline(TaskGroup group)
+{
+    unsigned long long deadline = ULLONG_MAX;
+    for (size_t i=0; i<tasksNum; i++)
+    {
+        if (taskGroups[i] == group && tasks[i].deadline < deadline) deadline = tasks[i].deadline;
+    }
+    return deadline;
+}
+
+// if any group with higher priority has a task running or due
+bool Scheduler::higherPriorityWork(TaskGroup group, unsigned long long currentTime)
+{
+    // status runs are short, they neither preempt nor delay other groups
+    for (int g=groupStatus+1; g<group; g++)
+    {
+        if (groups[g].runningTasks > 0 || earliestDeadline((TaskGroup) g) <= currentTime) return true;
+    }
+    return false;
+}
+
+// returns the current time as soon as a task of the group is due (or the scheduler is stopped)
+// due tasks wait for groups with higher priority, but at most maxPreemptionInMs
+unsigned long long Scheduler::waitForDueTask(TaskGroup group)
+{
+    unique_lock<mutex> lock(scheduler_mutex);
+    unsigned long long currentTime = systemTimeInMs();
+    bool delayed = false;
+    while (!stopped)
+    {
+        const unsigned long long deadline = earliestDeadline(group);
+        unsigned long long waitTime;
+        if (deadline > currentTime) waitTime = deadline - currentTime;
+        else if (currentTime - deadline >= maxPreemptionInMs || !higherPriorityWork(group, currentTime)) break;
+        else
+        {
+            waitTime = deadline + maxPreemptionInMs - currentTime;
+            if (!delayed) groups[group].preemptions++;
+            delayed = true;
+        }
+        if (waitTime > maxWaitTimeInMs) waitTime = maxWaitTimeInMs;
+        wakeUp.wait_for(lock, chrono::milliseconds(waitTime));
+        groups[group].wakeUps++;
+        currentTime = systemTimeInMs();
+    }
+    return currentTime;
+}
+
+// for long runs: true if the group should give way to a group with higher priority
+bool Scheduler::preempted(TaskGroup group)
+{
+    scheduler_mutex.lock();
+    const bool out = higherPriorityWork(group, systemTimeInMs());
+    if (out) groups[group].preemptions++;
+    scheduler_mutex.unlock();
+    return out;
+}
+
+bool Scheduler::isDue(SchedulerTask task, unsigned long long currentTime)
+{
+    scheduler_mutex.lock();
+    const bool due = (tasks[task].deadline <= currentTime);
+    scheduler_mutex.unlock();
+    return due;
+}
+
+// deadlines set during the run are kept if earlier than the next regular run
+void Scheduler::startRun(SchedulerTask task, unsigned long long currentTime)
+{
+    scheduler_mutex.lock();
+    TaskStatus &status = tasks[task];
+    if (status.deadline > 0 && status.deadline < currentTime)
+    {
+        const unsigned long long lag = currentTime - status.deadline;
+        status.lagTotalInMs += lag;
+        if (lag > status.lagMaxInMs) status.lagMaxInMs = lag;
+    }
+    status.deadline = ULLONG_MAX;
+    status.runStart = chrono::steady_clock::now();
+    groups[taskGroups[task]].runningTasks++;
+    scheduler_mutex.unlock();
+}
+
+void Scheduler::finishRun(SchedulerTask task, unsigned long long nextTime)
+{
+    scheduler_mutex.lock();
+    TaskStatus &status = tasks[task];
+    const unsigned long long runTime = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - status.runStart).count();
+    status.runs++;
+    status.runTimeTotalInMcrS += runTime;
+    if (runTime > status.runTimeMaxInMcrS) status.runTimeMaxInMcrS = runTime;
+    if (nextTime < status.deadline) status.deadline = nextTime;
+    groups[taskGroups[task]].runningTasks--;
+    scheduler_mutex.unlock();
+    // groups with lower priority may have waited for this
+    wakeUp.notify_all();
+}
+
+void Scheduler::stop()
+{
+    scheduler_mutex.lock();
+    stopped = true;
+    scheduler_mutex.unlock();
+    wakeUp.notify_all();
+}
+
+void Scheduler::report(string &msg)
+{
+    const unsigned long long currentTime = systemTimeInMs();
+    scheduler_mutex.lock();
+    for (size_t g=0; g<taskGroupsNum; g++)
+    {
+        msg.append("\ngroup ");
+        msg.append(groupNames[g]);
+        msg.append(": wake-ups: ");
+        msg.append(to_string(groups[g].wakeUps));
+        msg.append(", preemptions: ");
+        msg.append(to_string(groups[g].preemptions));
+    }
+    for (size_t i=0; i<tasksNum; i++)
+    {
+        TaskStatus &status = tasks[i];
+        msg.append("\n");
+        msg.append(taskNames[i]);
+        msg.append(" (");
+        msg.append(groupNames[taskGroups[i]]);
+        msg.append(")");
+        msg.append(": runs: ");
+        msg.append(to_string(status.runs));
+        if (status.runs > 0)
+        {
+            msg.append(", avg run time in mcrs: ");
+            msg.append(to_string(status.runTimeTotalInMcrS / status.runs));
+            msg.append(", max run time in mcrs: ");
+            msg.append(to_string(status.runTimeMaxInMcrS));
+            msg.append(", avg lag in ms: ");
+            msg.append(to_string(status.lagTotalInMs / status.runs));
+            msg.append(", max lag in ms: ");
+            msg.append(to_string(status.lagMaxInMs));
+        }
+        msg.append(", next run in ms: ");
+        if (status.deadline == ULLONG_MAX) msg.append("-");
+        else if (status.deadline <= currentTime) msg.append("0");
+        else msg.append(to_string(status.deadline - currentTime));
+    }
+    scheduler_mutex.unlock();
+}